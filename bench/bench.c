@@ -0,0 +1,449 @@
+/*
+** Benchmark suite for the public strlib operations. Each operation is timed
+** on strings from 16B to 64MB and reported in ns/op and in bytes/s of the
+** string operated on. Results are printed as a table and can also be
+** written as JSON for comparing runs.
+**
+** Usage: bench [--json PATH] [--max-size BYTES] [--min-time SECONDS]
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "strlib.h"
+
+// Sizes run by default, growing by 4x.
+#define MIN_SIZE ((size_t)16)
+#define MAX_SIZE ((size_t)64 << 20)
+
+// Needle planted throughout the text searched, replaced and removed.
+#define NEEDLE "needle"
+#define NEEDLE_LENGTH (sizeof(NEEDLE) - 1)
+#define NEEDLE_SPACING 1024
+
+// Number of chars inserted by every insert operation.
+#define INSERT_SIZE 16
+
+// Number of patterns searched for at once by the matcher, all but the
+// needle absent from the text.
+#define NUM_PATTERNS 1000
+
+// Number of fragments the text is assembled from by the concat operations.
+#define NUM_PARTS 32
+
+// Bound on the wall time of one measurement, in multiples of the minimum
+// measured time, as untimed setup can dominate fast operations.
+#define WALL_TIME_FACTOR 10
+
+// State shared by the operations of one size. `text` holds `size` chars
+// and a null terminator, `buf` is large enough for any slice of it and
+// `slices` and `matches` for every needle in it.
+typedef struct {
+  strlib_str_t *s;
+  strlib_str_t *rope;
+  strlib_matcher_t *matcher;
+  strlib_edits_t *edits;
+  strlib_intern_t *table;
+  char *text;
+  char *buf;
+  strlib_slice_t *slices;
+  strlib_match_t *matches;
+  strlib_view_t parts[NUM_PARTS];
+  size_t slices_size;
+  size_t size;
+} bench_state_t;
+
+// An operation under test. `setup` runs untimed before every batch of
+// `batch` timed calls of `run`. Inserts grow the string by INSERT_SIZE per
+// call until the next setup.
+typedef struct {
+  const char *name;
+  void (*setup)(bench_state_t *state);
+  void (*run)(bench_state_t *state);
+  size_t batch;
+} bench_op_t;
+
+// Measurement of one operation at one size.
+typedef struct {
+  const char *name;
+  size_t size;
+  size_t iterations;
+  double ns_per_op;
+  double bytes_per_second;
+} bench_result_t;
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+static void fill_text(char *text, const size_t size) {
+  // lowercase text without needles, then one needle every NEEDLE_SPACING
+  unsigned seed = 1;
+  for (size_t i = 0; i < size; i++) {
+    seed = (seed * 1103515245u) + 12345u;
+    text[i] = (char)('a' + ((seed >> 16) % 26));
+    if (i >= 2 && memcmp(text + i - 2, "nee", 3) == 0) {
+      text[i] = 'x';
+    }
+  }
+  for (size_t i = NEEDLE_SPACING / 2; i + NEEDLE_LENGTH <= size;
+       i += NEEDLE_SPACING) {
+    memcpy(text + i, NEEDLE, NEEDLE_LENGTH);
+  }
+  text[size] = '\0';
+}
+
+static void reset_string(bench_state_t *state) {
+  strlib_result_t res = strlib_set(state->s, state->text, state->size + 1);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void reset_rope(bench_state_t *state) {
+  // the first insert takes the flat contents over as the rope's base
+  strlib_result_t res =
+      strlib_set(state->rope, state->text, state->size + 1);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_insert_chars(bench_state_t *state) {
+  strlib_result_t res = strlib_insert_chars(state->s, state->text, INSERT_SIZE,
+                                            state->size / 2, false);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_insert_chars_rope(bench_state_t *state) {
+  strlib_result_t res = strlib_insert_chars(
+      state->rope, state->text, INSERT_SIZE, state->size / 2, false);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_find_substr(bench_state_t *state) {
+  size_t num_positions = 0;
+  strlib_result_t res = strlib_find_substr(
+      state->s, state->slices, &num_positions, state->slices_size, NEEDLE);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_matcher_find(bench_state_t *state) {
+  size_t num_matches = 0;
+  strlib_result_t res = strlib_matcher_find(
+      state->matcher, state->s, state->matches, &num_matches,
+      state->slices_size);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_replace_substr(bench_state_t *state) {
+  strlib_result_t res = strlib_replace_substr(state->s, NEEDLE, "pin");
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_replace_many(bench_state_t *state) {
+  // an escaping table, with the needle standing in for one of its chars
+  static const strlib_view_t needles[] = {
+      {.chars = NEEDLE, .length = NEEDLE_LENGTH},
+      {.chars = "<", .length = 1},
+      {.chars = ">", .length = 1},
+      {.chars = "\"", .length = 1},
+  };
+  static const strlib_view_t replacements[] = {
+      {.chars = "&amp;", .length = 5},
+      {.chars = "&lt;", .length = 4},
+      {.chars = "&gt;", .length = 4},
+      {.chars = "&quot;", .length = 6},
+  };
+  strlib_result_t res = strlib_replace_many(state->s, needles, replacements,
+                                            4);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_apply_edits(bench_state_t *state) {
+  // replace every needle and insert a char after it, all in one batch
+  strlib_result_t res = strlib_edits_reset(state->edits);
+  assert(res.code == STRLIB_E_SUCCESS);
+  for (size_t i = NEEDLE_SPACING / 2; i + NEEDLE_LENGTH <= state->size;
+       i += NEEDLE_SPACING) {
+    res = strlib_edits_replace(
+        state->edits,
+        (strlib_slice_t){.start = i, .end = i + NEEDLE_LENGTH - 1},
+        (strlib_view_t){.chars = "pin", .length = 3});
+    assert(res.code == STRLIB_E_SUCCESS);
+    res = strlib_edits_insert(state->edits, i + NEEDLE_LENGTH,
+                              (strlib_view_t){.chars = "!", .length = 1});
+    assert(res.code == STRLIB_E_SUCCESS);
+  }
+  res = strlib_apply_edits(state->s, state->edits);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_intern(bench_state_t *state) {
+  // every call after the first finds the text interned already
+  const strlib_str_t *interned = NULL;
+  strlib_result_t res = strlib_intern(
+      state->table,
+      (strlib_view_t){.chars = state->text, .length = state->size},
+      &interned);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_hash_view(bench_state_t *state) {
+  // the view is hashed every call, unlike strings which cache their hash
+  uint64_t hash = 0;
+  strlib_result_t res = strlib_hash_view(
+      (strlib_view_t){.chars = state->text, .length = state->size}, &hash);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+  (void)hash;
+}
+
+static void split_text(bench_state_t *state) {
+  // cut the text into NUM_PARTS fragments of nearly equal length
+  for (size_t i = 0; i < NUM_PARTS; i++) {
+    size_t start = (state->size * i) / NUM_PARTS;
+    size_t end = (state->size * (i + 1)) / NUM_PARTS;
+    state->parts[i] = (strlib_view_t){
+        .chars = state->text + start,
+        .length = end - start,
+    };
+  }
+}
+
+static void run_insert_parts(bench_state_t *state) {
+  // assemble a new string the way callers did before strlib_concat
+  strlib_str_t *s = NULL;
+  strlib_result_t res = strlib_init(&s);
+  assert(res.code == STRLIB_E_SUCCESS);
+  size_t length = 0;
+  for (size_t i = 0; i < NUM_PARTS; i++) {
+    res = strlib_insert_chars(s, state->parts[i].chars,
+                              state->parts[i].length, length, false);
+    assert(res.code == STRLIB_E_SUCCESS);
+    length += state->parts[i].length;
+  }
+  res = strlib_free(s);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_concat(bench_state_t *state) {
+  strlib_str_t *s = NULL;
+  strlib_result_t res = strlib_init(&s);
+  assert(res.code == STRLIB_E_SUCCESS);
+  res = strlib_concat(s, state->parts, NUM_PARTS);
+  assert(res.code == STRLIB_E_SUCCESS);
+  res = strlib_free(s);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_remove_substr(bench_state_t *state) {
+  strlib_result_t res = strlib_remove_substr(state->s, NEEDLE);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_set(bench_state_t *state) {
+  strlib_result_t res = strlib_set(state->s, state->text, state->size + 1);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static void run_get_slice(bench_state_t *state) {
+  strlib_result_t res =
+      strlib_get_slice(state->s, state->buf, state->size + 1,
+                       (strlib_slice_t){.start = 0, .end = state->size - 1});
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+}
+
+static const bench_op_t ops[] = {
+    {"insert_chars", reset_string, run_insert_chars, 16},
+    {"insert_chars_rope", reset_rope, run_insert_chars_rope, 1024},
+    {"find_substr", reset_string, run_find_substr, 64},
+    {"matcher_find", reset_string, run_matcher_find, 64},
+    {"replace_substr", reset_string, run_replace_substr, 1},
+    {"replace_many", reset_string, run_replace_many, 1},
+    {"apply_edits", reset_string, run_apply_edits, 1},
+    {"intern", reset_string, run_intern, 64},
+    {"hash_view", reset_string, run_hash_view, 64},
+    {"insert_parts", split_text, run_insert_parts, 64},
+    {"concat", split_text, run_concat, 64},
+    {"remove_substr", reset_string, run_remove_substr, 1},
+    {"set", reset_string, run_set, 64},
+    {"get_slice", reset_string, run_get_slice, 64},
+};
+
+static strlib_matcher_t *compile_matcher(void) {
+  // the needle, then words of 8 uppercase chars which never occur
+  static char words[NUM_PATTERNS][8];
+  static strlib_view_t patterns[NUM_PATTERNS];
+  unsigned seed = 2;
+  patterns[0] = (strlib_view_t){.chars = NEEDLE, .length = NEEDLE_LENGTH};
+  for (size_t i = 1; i < NUM_PATTERNS; i++) {
+    for (size_t j = 0; j < sizeof(words[i]); j++) {
+      seed = (seed * 1103515245u) + 12345u;
+      words[i][j] = (char)('A' + ((seed >> 16) % 26));
+    }
+    patterns[i] =
+        (strlib_view_t){.chars = words[i], .length = sizeof(words[i])};
+  }
+  strlib_matcher_t *matcher = NULL;
+  strlib_result_t res = strlib_matcher_init(&matcher, patterns, NUM_PATTERNS);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+  return matcher;
+}
+
+static bench_result_t measure(const bench_op_t *op, bench_state_t *state,
+                              const double min_ns) {
+  // repeat batches until enough time has been measured
+  double wall_start = now_ns();
+  double elapsed = 0;
+  size_t iterations = 0;
+  do {
+    op->setup(state);
+    double start = now_ns();
+    for (size_t i = 0; i < op->batch; i++) {
+      op->run(state);
+    }
+    elapsed += now_ns() - start;
+    iterations += op->batch;
+  } while (elapsed < min_ns &&
+           now_ns() - wall_start < WALL_TIME_FACTOR * min_ns);
+
+  double ns_per_op = elapsed / (double)iterations;
+  return (bench_result_t){
+      .name = op->name,
+      .size = state->size,
+      .iterations = iterations,
+      .ns_per_op = ns_per_op,
+      .bytes_per_second = (double)state->size * 1e9 / ns_per_op,
+  };
+}
+
+static void write_json(FILE *out, const bench_result_t *results,
+                       const size_t num_results) {
+  fprintf(out, "{\n  \"benchmarks\": [\n");
+  for (size_t i = 0; i < num_results; i++) {
+    fprintf(out,
+            "    {\"operation\": \"%s\", \"size\": %zu, \"iterations\": %zu, "
+            "\"ns_per_op\": %.2f, \"bytes_per_second\": %.0f}%s\n",
+            results[i].name, results[i].size, results[i].iterations,
+            results[i].ns_per_op, results[i].bytes_per_second,
+            (i + 1 < num_results) ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+_Noreturn static void usage(void) {
+  fprintf(stderr,
+          "usage: bench [--json PATH] [--max-size BYTES] "
+          "[--min-time SECONDS]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  const char *json_path = NULL;
+  size_t max_size = MAX_SIZE;
+  double min_ns = 0.1 * 1e9;
+
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    if (strcmp(argv[i], "--json") == 0) {
+      json_path = argv[++i];
+    } else if (strcmp(argv[i], "--max-size") == 0) {
+      max_size = (size_t)strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--min-time") == 0) {
+      min_ns = strtod(argv[++i], NULL) * 1e9;
+    } else {
+      usage();
+    }
+  }
+  if (max_size < MIN_SIZE) usage();
+
+  // buffers are sized once for the largest string
+  size_t num_ops = sizeof(ops) / sizeof(ops[0]);
+  size_t num_sizes = 0;
+  size_t largest = MIN_SIZE;
+  for (size_t size = MIN_SIZE; size <= max_size; size *= 4) {
+    largest = size;
+    num_sizes++;
+  }
+  bench_state_t state = {0};
+  state.text = malloc(largest + 1);
+  state.buf = malloc(largest + 1);
+  state.slices_size = (largest / NEEDLE_SPACING) + 1;
+  state.slices = malloc(state.slices_size * sizeof(strlib_slice_t));
+  state.matches = malloc(state.slices_size * sizeof(strlib_match_t));
+  bench_result_t *results = malloc(num_ops * num_sizes * sizeof(*results));
+  if (state.text == NULL || state.buf == NULL || state.slices == NULL ||
+      state.matches == NULL || results == NULL) {
+    fprintf(stderr, "bench: out of memory\n");
+    return 1;
+  }
+  strlib_result_t res = strlib_init(&state.s);
+  assert(res.code == STRLIB_E_SUCCESS);
+  res = strlib_init_with_representation(&state.rope,
+                                        STRLIB_REPRESENTATION_ROPE, NULL);
+  assert(res.code == STRLIB_E_SUCCESS);
+  res = strlib_edits_init(&state.edits);
+  assert(res.code == STRLIB_E_SUCCESS);
+  res = strlib_intern_init(&state.table);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+  state.matcher = compile_matcher();
+
+  printf("%-18s %10s %12s %14s %12s\n", "operation", "size", "iterations",
+         "ns/op", "MB/s");
+  size_t num_results = 0;
+  for (size_t size = MIN_SIZE; size <= max_size; size *= 4) {
+    state.size = size;
+    fill_text(state.text, size);
+    for (size_t i = 0; i < num_ops; i++) {
+      bench_result_t result = measure(&ops[i], &state, min_ns);
+      printf("%-18s %10zu %12zu %14.1f %12.1f\n", result.name, result.size,
+             result.iterations, result.ns_per_op,
+             result.bytes_per_second / 1e6);
+      fflush(stdout);
+      results[num_results++] = result;
+    }
+  }
+
+  if (json_path != NULL) {
+    FILE *out = fopen(json_path, "w");
+    if (out == NULL) {
+      fprintf(stderr, "bench: cannot write %s\n", json_path);
+      return 1;
+    }
+    write_json(out, results, num_results);
+    fclose(out);
+  }
+
+  strlib_free(state.s);
+  strlib_free(state.rope);
+  strlib_matcher_free(state.matcher);
+  strlib_edits_free(state.edits);
+  strlib_intern_free(state.table);
+  free(state.text);
+  free(state.buf);
+  free(state.slices);
+  free(state.matches);
+  free(results);
+  return 0;
+}
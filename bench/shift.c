@@ -0,0 +1,133 @@
+/*
+** Microbenchmark for the block-move kernels behind insertion, removal and
+** reversed slicing. Every operation is timed through the public strlib API
+** and against the byte-at-a-time loops the kernels replaced, on strings from
+** 1KB to 1MB.
+*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "strlib.h"
+
+// Number of chars inserted and removed again by every iteration.
+#define INSERT_SIZE 16
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+static size_t iterations_for(const size_t size) {
+  // keep every measurement at roughly the same number of bytes moved
+  size_t iterations = ((size_t)256 << 20) / size;
+  return (iterations < 16) ? 16 : iterations;
+}
+
+// The reference loops write through volatile pointers so that compilers
+// cannot turn them back into memmove/memcpy calls.
+static void byte_loop_insert_remove(volatile char *chars, const size_t length,
+                                    const char *cs, const size_t position) {
+  // the loops strlib_insert_chars and strlib_remove_slice used to run
+  for (size_t i = length + INSERT_SIZE; i >= position + INSERT_SIZE; i--) {
+    chars[i] = chars[i - INSERT_SIZE];
+  }
+  for (size_t i = 0; i < INSERT_SIZE; i++) {
+    chars[i + position] = cs[i];
+  }
+  for (size_t i = position; i <= length; i++) {
+    chars[i] = chars[i + INSERT_SIZE];
+  }
+}
+
+static void byte_loop_reverse(volatile char *buf, const char *chars,
+                              const size_t length) {
+  // the loop strlib_get_slice used to run for reversed slices
+  size_t idx = length - 1;
+  for (size_t i = 0; i < length; i++) {
+    buf[i] = chars[idx];
+    idx--;
+  }
+  buf[length] = '\0';
+}
+
+static void report(const char *op, const size_t size, const double kernel_ns,
+                   const double loop_ns) {
+  printf("%-22s %9zu %15.1f %15.1f %8.2fx\n", op, size, kernel_ns, loop_ns,
+         loop_ns / kernel_ns);
+}
+
+static void bench_size(const size_t size) {
+  strlib_str_t *s = NULL;
+  char *chars = malloc(size + INSERT_SIZE + 1);
+  char *buf = malloc(size + 2);
+  const char cs[INSERT_SIZE] = "0123456789abcdef";
+  size_t iterations = iterations_for(size);
+  strlib_result_t ret1;
+  double start;
+  double kernel_ns;
+  double loop_ns;
+
+  assert(chars != NULL && buf != NULL);
+  memset(chars, 'x', size);
+  chars[size] = '\0';
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, chars, size, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // insert into and remove from the middle of the string
+  start = now_ns();
+  for (size_t i = 0; i < iterations; i++) {
+    ret1 = strlib_insert_chars(s, cs, INSERT_SIZE, size / 2, false);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_remove_slice(
+        s, (strlib_slice_t){.start = size / 2,
+                            .end = (size / 2) + INSERT_SIZE - 1});
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  kernel_ns = (now_ns() - start) / (double)iterations;
+  start = now_ns();
+  for (size_t i = 0; i < iterations; i++) {
+    byte_loop_insert_remove(chars, size, cs, size / 2);
+  }
+  loop_ns = (now_ns() - start) / (double)iterations;
+  report("insert+remove middle", size, kernel_ns, loop_ns);
+
+  // copy the whole string out reversed
+  start = now_ns();
+  for (size_t i = 0; i < iterations; i++) {
+    ret1 = strlib_get_slice(s, buf, size + 1,
+                            (strlib_slice_t){.start = size - 1, .end = 0});
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  kernel_ns = (now_ns() - start) / (double)iterations;
+  start = now_ns();
+  for (size_t i = 0; i < iterations; i++) {
+    byte_loop_reverse(buf, chars, size);
+  }
+  loop_ns = (now_ns() - start) / (double)iterations;
+  report("reversed slice", size, kernel_ns, loop_ns);
+
+  // keep the reference loops from being optimized away
+  assert(buf[0] == 'x' && chars[size / 2] == 'x');
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  free(chars);
+  free(buf);
+}
+
+int main(void) {
+  printf("%-22s %9s %15s %15s %9s\n", "operation", "size", "kernel ns/op",
+         "byte loop ns/op", "speedup");
+  for (size_t size = 1024; size <= ((size_t)1 << 20); size *= 4) {
+    bench_size(size);
+  }
+  return 0;
+}
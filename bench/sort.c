@@ -0,0 +1,106 @@
+/*
+** Microbenchmark for strlib_sort. Batches of keys are sorted through the
+** public strlib API and, for reference, by qsort with strlib_compare and
+** by qsort with strcmp on the keys copied out, as callers did before.
+** Keys share a prefix and vary in length, as record keys tend to.
+*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "strlib.h"
+
+// Longest key generated, excluding its terminator.
+#define MAX_KEY_LENGTH 48
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+static int compare_strs(const void *a, const void *b) {
+  int cmp = 0;
+  strlib_result_t res = strlib_compare(*(strlib_str_t *const *)a,
+                                       *(strlib_str_t *const *)b, &cmp);
+  assert(res.code == STRLIB_E_SUCCESS);
+  (void)res;
+  return cmp;
+}
+
+static int compare_cstrs(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void report(const char *op, const size_t count, const double ns) {
+  printf("%-24s %9zu %12.1f %10.1f\n", op, count, ns / 1e6,
+         ns / (double)count);
+}
+
+static void bench_count(const size_t count) {
+  strlib_str_t **keys = malloc(count * sizeof(strlib_str_t *));
+  strlib_str_t **sorted = malloc(count * sizeof(strlib_str_t *));
+  char **cstrs = malloc(count * sizeof(char *));
+  uint32_t seed = 12345;
+  strlib_result_t res;
+  double start;
+
+  assert(keys != NULL && sorted != NULL && cstrs != NULL);
+  for (size_t i = 0; i < count; i++) {
+    char key[MAX_KEY_LENGTH + 1];
+    seed = seed * 1103515245u + 12345u;
+    int n = snprintf(key, sizeof(key), "tenant-%02u/user-%08x/%.*s",
+                     (seed >> 24) % 16, seed * 2654435761u,
+                     (int)((seed >> 8) % 16), "events-by-day-");
+    assert(n > 0 && (size_t)n <= MAX_KEY_LENGTH);
+    res = strlib_init(&keys[i]);
+    assert(res.code == STRLIB_E_SUCCESS);
+    res = strlib_set_n(keys[i], key, (size_t)n);
+    assert(res.code == STRLIB_E_SUCCESS);
+    cstrs[i] = malloc(MAX_KEY_LENGTH + 1);
+    assert(cstrs[i] != NULL);
+  }
+
+  memcpy(sorted, keys, count * sizeof(strlib_str_t *));
+  start = now_ns();
+  res = strlib_sort(sorted, count);
+  assert(res.code == STRLIB_E_SUCCESS);
+  report("strlib_sort", count, now_ns() - start);
+
+  memcpy(sorted, keys, count * sizeof(strlib_str_t *));
+  start = now_ns();
+  qsort(sorted, count, sizeof(strlib_str_t *), compare_strs);
+  report("qsort strlib_compare", count, now_ns() - start);
+
+  // the copies out are part of what callers paid for
+  start = now_ns();
+  for (size_t i = 0; i < count; i++) {
+    res = strlib_get(keys[i], cstrs[i], MAX_KEY_LENGTH + 1);
+    assert(res.code == STRLIB_E_SUCCESS);
+  }
+  qsort(cstrs, count, sizeof(char *), compare_cstrs);
+  report("strlib_get+qsort strcmp", count, now_ns() - start);
+
+  for (size_t i = 0; i < count; i++) {
+    free(cstrs[i]);
+    res = strlib_free(keys[i]);
+    assert(res.code == STRLIB_E_SUCCESS);
+  }
+  (void)res;
+  free(cstrs);
+  free(sorted);
+  free(keys);
+}
+
+int main(void) {
+  printf("%-24s %9s %12s %10s\n", "operation", "keys", "ms", "ns/key");
+  for (size_t count = 1000; count <= 1000000; count *= 10) {
+    bench_count(count);
+  }
+  return 0;
+}
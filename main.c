@@ -1,7 +1,12 @@
 #include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "strlib.h"
 
@@ -20,7 +25,7 @@ static void test_init(void) {
 
   ret1 = strlib_get_capacity(s, &x);
   assert(ret1.code == STRLIB_E_SUCCESS);
-  assert(x == 256);
+  assert(x == STRLIB_SMALL_CAPACITY);
 
   ret1 = strlib_free(s);
   assert(ret1.code == STRLIB_E_SUCCESS);
@@ -76,7 +81,7 @@ static void test_char_operations(void) {
   assert(x == 3);
   ret1 = strlib_get_capacity(s, &x);
   assert(ret1.code == STRLIB_E_SUCCESS);
-  assert(x == 256);
+  assert(x == STRLIB_SMALL_CAPACITY);
 
   // test insert char
   ret1 = strlib_insert_char(s, 'r', 1);
@@ -190,7 +195,7 @@ static void test_string_operations(void) {
   assert(x == 8);
 
   // test replace substring
-  ret1 = strlib_set(s, "foobarrrrabbarr", 15);
+  ret1 = strlib_set(s, "foobarrrrabbarr", 16);
   ret1 = strlib_replace_substr(s, "barr", "baz");
   assert(ret1.code == STRLIB_E_SUCCESS);
   ret1 = strlib_get(s, buf, 256);
@@ -200,6 +205,2425 @@ static void test_string_operations(void) {
   assert(ret1.code == STRLIB_E_SUCCESS);
 }
 
+static void test_small_string(void) {
+  strlib_str_t *s = NULL;
+  char buf[256] = {0};
+  strlib_result_t ret1;
+  size_t x;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test contents that fit stay inline
+  ret1 = strlib_set(s, "short key", 10);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == STRLIB_SMALL_CAPACITY);
+
+  // test growing past the inline buffer keeps the contents
+  ret1 = strlib_insert_chars(s, " that no longer fits inline", 27, 9, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, 256);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "short key that no longer fits inline") == 0);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x > STRLIB_SMALL_CAPACITY);
+
+  // test shrinking moves the contents back inline
+  ret1 = strlib_remove_slice(s, (strlib_slice_t){.start = 9, .end = 35});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_shrink_to_fit(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == STRLIB_SMALL_CAPACITY);
+  ret1 = strlib_get(s, buf, 256);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "short key") == 0);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_growth_policy(void) {
+  static char text[10000];
+  strlib_str_t *s = NULL;
+  strlib_growth_policy_t policy;
+  strlib_result_t ret1;
+  size_t x;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_growth_policy(s, &policy);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(policy.strategy == STRLIB_GROWTH_GEOMETRIC);
+
+  // test geometric growth doubles small buffers
+  for (size_t i = 0; i < 256; i++) {
+    ret1 = strlib_insert_char(s, 'a', i);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == STRLIB_SMALL_CAPACITY * 16);
+
+  // test shrink to fit and reserve
+  ret1 = strlib_shrink_to_fit(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 257);
+  ret1 = strlib_reserve(s, 1000);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 1000);
+
+  // test exact growth
+  ret1 = strlib_set_growth_policy(
+      s, (strlib_growth_policy_t){.strategy = STRLIB_GROWTH_EXACT});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_shrink_to_fit(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, "bcd", 3, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 260);
+
+  // test page rounded growth
+  ret1 = strlib_set_growth_policy(
+      s, (strlib_growth_policy_t){.strategy = STRLIB_GROWTH_PAGE});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_char(s, 'e', 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 4096);
+
+  // test capped growth
+  ret1 = strlib_set_growth_policy(
+      s, (strlib_growth_policy_t){.strategy = STRLIB_GROWTH_CAPPED});
+  assert(ret1.code == STRLIB_E_BAD_SIZE);
+  ret1 = strlib_set_growth_policy(
+      s, (strlib_growth_policy_t){.strategy = STRLIB_GROWTH_CAPPED,
+                                  .limit = 100});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_shrink_to_fit(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_char(s, 'f', 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 361);
+  // past the cap the capacity grows in whole steps of the limit
+  memset(text, 'h', sizeof(text));
+  ret1 = strlib_set_n(s, text, sizeof(text));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 361 + (((sizeof(text) + 1 - 361 + 99) / 100) * 100));
+
+  // test inserting past the end is rejected
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_char(s, 'g', x + 1);
+  assert(ret1.code == STRLIB_E_BAD_INDEX);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_allocators(void) {
+  strlib_arena_t *arena = NULL;
+  strlib_pool_t *pool = NULL;
+  const strlib_allocator_t *allocator = NULL;
+  strlib_str_t *strs[64] = {NULL};
+  char buf[256] = {0};
+  strlib_result_t ret1;
+
+  // test arena backed strings are dropped by a reset
+  ret1 = strlib_arena_init(&arena, 1024);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_arena_get_allocator(arena, &allocator);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t round = 0; round < 2; round++) {
+    for (size_t i = 0; i < 64; i++) {
+      ret1 = strlib_init_with_allocator(&strs[i], allocator);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+      ret1 = strlib_set(strs[i], "a string that lives on the heap", 32);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+      ret1 = strlib_insert_chars(strs[i], "arena ", 6, 2, false);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+    }
+    ret1 = strlib_get(strs[63], buf, 256);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(strcmp(buf, "a arena string that lives on the heap") == 0);
+    ret1 = strlib_arena_reset(arena);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  ret1 = strlib_arena_free(arena);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test pool backed strings are bounded by the object size
+  ret1 = strlib_pool_init(&pool, 128, 16);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_pool_get_allocator(pool, &allocator);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init_with_allocator(&strs[0], allocator);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set(strs[0], "a string that lives on the heap", 32);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i < 96; i++) {
+    ret1 = strlib_insert_char(strs[0], 'x', 0);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  ret1 = strlib_insert_char(strs[0], 'x', 0);
+  assert(ret1.code == STRLIB_E_NO_MEMORY);
+  ret1 = strlib_free(strs[0]);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_pool_free(pool);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_views(void) {
+  strlib_str_t *s = NULL;
+  strlib_str_t *t = NULL;
+  char buf[256] = {0};
+  strlib_result_t ret1;
+  strlib_view_t view;
+  strlib_slice_t slices[16] = {0};
+  size_t x;
+  int cmp;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init(&t);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set(s, "key=value;key=other", 20);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test borrowing the whole string and a slice
+  ret1 = strlib_get_view(s, &view);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(view.length == 19);
+  assert(memcmp(view.chars, "key=value;key=other", 19) == 0);
+  ret1 =
+      strlib_get_slice_view(s, &view, (strlib_slice_t){.start = 4, .end = 8});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(view.length == 5);
+  assert(memcmp(view.chars, "value", 5) == 0);
+  ret1 =
+      strlib_get_slice_view(s, &view, (strlib_slice_t){.start = 8, .end = 4});
+  assert(ret1.code == STRLIB_E_BAD_INDEX);
+  ret1 = strlib_get_slice_view(s, &view,
+                               (strlib_slice_t){.start = 4, .end = 19});
+  assert(ret1.code == STRLIB_E_BAD_INDEX);
+
+  // test finding a view with an embedded null character
+  ret1 = strlib_find_substr_view(s, slices, &x, 16,
+                                 (strlib_view_t){.chars = "key", .length = 3});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 2);
+  assert(slices[1].start == 10);
+  assert(slices[1].end == 12);
+  ret1 = strlib_find_substr_view(
+      s, slices, &x, 16, (strlib_view_t){.chars = "key\0", .length = 4});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 0);
+
+  // test inserting and replacing from views of another string
+  ret1 =
+      strlib_get_slice_view(s, &view, (strlib_slice_t){.start = 4, .end = 8});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_view(t, view, 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_slice_view(
+      t, (strlib_view_t){.chars = "VAL", .length = 3},
+      (strlib_slice_t){.start = 0, .end = 2});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(t, buf, 256);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "VALue") == 0);
+
+  // test comparing against views
+  ret1 = strlib_compare_view(t, (strlib_view_t){.chars = "VALue", .length = 5},
+                             &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(cmp == 0);
+  ret1 = strlib_compare_view(t, (strlib_view_t){.chars = "VAL", .length = 3},
+                             &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(cmp == 1);
+  ret1 = strlib_compare_view(t, (strlib_view_t){.chars = "value", .length = 5},
+                             &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(cmp == -1);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(t);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static size_t naive_find(const char *chars, const size_t length,
+                         const char *substr, const size_t len_substr,
+                         strlib_slice_t *slices) {
+  size_t num_positions = 0;
+  for (size_t i = 0; len_substr != 0 && i + len_substr <= length; i++) {
+    if (memcmp(chars + i, substr, len_substr) == 0) {
+      slices[num_positions++] =
+          (strlib_slice_t){.start = i, .end = i + len_substr - 1};
+    }
+  }
+  return num_positions;
+}
+
+static void test_search_engine(void) {
+  strlib_str_t *s = NULL;
+  static char chars[4096];
+  static char substr[128];
+  static strlib_slice_t expected[4096];
+  static strlib_slice_t slices[4096];
+  strlib_result_t ret1;
+  unsigned seed = 12345;
+  size_t x;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test every kernel against a naive search on small, periodic alphabets
+  for (size_t round = 0; round < 300; round++) {
+    size_t length = 1 + (round * 13) % sizeof(chars);
+    size_t len_substr = 1 + (round * 7) % sizeof(substr);
+    char alphabet = (char)(1 + round % 3);
+    for (size_t i = 0; i < length; i++) {
+      seed = seed * 1103515245u + 12345u;
+      chars[i] = (char)('a' + (char)((seed >> 16) % (unsigned)alphabet));
+    }
+    for (size_t i = 0; i < len_substr; i++) {
+      seed = seed * 1103515245u + 12345u;
+      substr[i] = (char)('a' + (char)((seed >> 16) % (unsigned)alphabet));
+    }
+    // plant the needle so that long needles match as well
+    if (len_substr <= length) {
+      memcpy(chars + (length - len_substr) / 2, substr, len_substr);
+    }
+
+    ret1 = strlib_set(s, "", 1);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_insert_chars(s, chars, length, 0, false);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_find_substr_view(
+        s, slices, &x, 4096,
+        (strlib_view_t){.chars = substr, .length = len_substr});
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(x == naive_find(chars, length, substr, len_substr, expected));
+    assert(memcmp(slices, expected, x * sizeof(strlib_slice_t)) == 0);
+  }
+
+  // test matches across embedded null characters
+  ret1 = strlib_set(s, "", 1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, "ab\0cd\0ab\0cd", 11, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_find_substr_view(
+      s, slices, &x, 4096, (strlib_view_t){.chars = "\0cd", .length = 3});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 2);
+  assert(slices[0].start == 2);
+  assert(slices[1].start == 8);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_char_scan(void) {
+  strlib_str_t *s = NULL;
+  static char chars[1000];
+  static size_t positions[1000];
+  strlib_result_t ret1;
+  size_t expected = 0;
+  size_t commas = 0;
+  size_t x;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test delimiters across vector blocks and the tail
+  for (size_t i = 0; i < sizeof(chars); i++) {
+    chars[i] = (i % 7 == 3) ? ',' : (i % 11 == 5) ? ';' : 'x';
+  }
+  ret1 = strlib_insert_chars(s, chars, sizeof(chars), 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_find_char(s, positions, &x, 1000, ',');
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i < sizeof(chars); i++) {
+    if (chars[i] == ',') {
+      assert(positions[expected++] == i);
+    }
+  }
+  assert(x == expected);
+  commas = expected;
+
+  // test any char of a set, including sets too large for vectors
+  ret1 = strlib_find_any_char(s, positions, &x, 1000, ";,");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  expected = 0;
+  for (size_t i = 0; i < sizeof(chars); i++) {
+    if (chars[i] == ',' || chars[i] == ';') {
+      assert(positions[expected++] == i);
+    }
+  }
+  assert(x == expected);
+  ret1 = strlib_find_any_char(s, positions, &x, 1000, "abcdefghijklmn;");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == expected - commas);
+  assert(positions[0] == 5);
+
+  // test the positions buffer is never overrun
+  ret1 = strlib_find_char(s, positions, &x, 3, ',');
+  assert(ret1.code == STRLIB_E_BAD_SIZE);
+  assert(x == 3);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_replace_substr(void) {
+  strlib_str_t *s = NULL;
+  static char buf[8192];
+  strlib_result_t ret1;
+  size_t x;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test growing replacements which contain the needle
+  ret1 = strlib_set(s, "a{x}b{x}{x}", 12);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_substr(s, "{x}", "<{x}>");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "a<{x}>b<{x}><{x}>") == 0);
+
+  // test shrinking replacements and non-overlapping matches
+  ret1 = strlib_set(s, "aaaaa", 6);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_substr(s, "aa", "b");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "bba") == 0);
+
+  // test limiting the number of replacements
+  ret1 = strlib_set(s, "x.x.x.x", 8);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_substr_max(s, "x", "yy", 2, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 2);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "yy.yy.x.x") == 0);
+
+  // test more matches than the old fixed slice buffer could hold
+  ret1 = strlib_set(s, "", 1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i < 1000; i++) {
+    ret1 = strlib_insert_chars(s, "$a;", 3, 0, false);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  ret1 = strlib_replace_substr_max(s, "$a", "value", SIZE_MAX, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 1000);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 6000);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strncmp(buf, "value;value;", 12) == 0);
+  assert(strcmp(buf + 5988, "value;value;") == 0);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_remove_compaction(void) {
+  strlib_str_t *s = NULL;
+  char buf[256] = {0};
+  strlib_result_t ret1;
+  const strlib_slice_t unordered[] = {
+      {.start = 9, .end = 10},
+      {.start = 2, .end = 0},
+      {.start = 1, .end = 4},
+  };
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test every match is removed in one pass
+  ret1 = strlib_set(s, "<b>bold</b> and <b>more</b>", 28);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_remove_substr(s, "<b>");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_remove_substr(s, "</b>");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, 256);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "bold and more") == 0);
+
+  // test removing unordered, overlapping and reversed slices
+  ret1 = strlib_set(s, "0123456789ab", 13);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_remove_slices(s, unordered, 3);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, 256);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "5678b") == 0);
+  ret1 = strlib_remove_slices(s, unordered, 1);
+  assert(ret1.code == STRLIB_E_BAD_INDEX);
+
+  // test removing every char of a set
+  ret1 = strlib_set(s, "a\tb\r\nc\001d", 10);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_remove_any_char(s, "\t\r\n\001");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, 256);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "abcd") == 0);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_block_moves(void) {
+  strlib_str_t *s = NULL;
+  char chars[100] = {0};
+  char buf[256] = {0};
+  strlib_result_t ret1;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i < sizeof(chars); i++) {
+    chars[i] = (char)('!' + i % 90);
+  }
+
+  // test reversed inserts write the chars last to first
+  ret1 = strlib_insert_chars(s, chars, sizeof(chars), 0, true);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, 256);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i < sizeof(chars); i++) {
+    assert(buf[i] == chars[sizeof(chars) - 1 - i]);
+  }
+
+  // test reversed slices longer than a vector
+  ret1 = strlib_get_slice(s, buf, 256, (strlib_slice_t){.start = 98, .end = 1});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(memcmp(buf, chars + 1, 98) == 0);
+  assert(buf[98] == '\0');
+
+  // test empty inserts and removes in the middle
+  ret1 = strlib_insert_chars(s, "", 0, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_remove_slice(s, (strlib_slice_t){.start = 10, .end = 89});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, "mid", 3, 10, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, 256);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strlen(buf) == 23);
+  assert(memcmp(buf + 10, "mid", 3) == 0);
+  assert(buf[13] == chars[9]);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void check_rope_matches(const strlib_str_t *rope,
+                               const strlib_str_t *flat) {
+  static char expected[4096];
+  static char actual[4096];
+  size_t length = 0;
+  strlib_result_t ret1;
+
+  ret1 = strlib_get(flat, expected, sizeof(expected));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(rope, actual, sizeof(actual));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(rope, &length);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(length == strlen(expected));
+  assert(strcmp(actual, expected) == 0);
+}
+
+static void test_rope(void) {
+  strlib_str_t *rope = NULL;
+  strlib_str_t *flat = NULL;
+  char buf[4096] = {0};
+  char c = '\0';
+  size_t positions[16] = {0};
+  size_t num_positions = 0;
+  size_t length = 0;
+  size_t x = 0;
+  int cmp = 1;
+  uint32_t seed = 12345;
+  strlib_view_t view;
+  strlib_result_t ret1;
+
+  ret1 = strlib_init_with_representation(&rope, STRLIB_REPRESENTATION_ROPE,
+                                         NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init(&flat);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test random edits match the same edits on a flat string
+  for (size_t i = 0; i < 2000; i++) {
+    seed = seed * 1103515245u + 12345u;
+    ret1 = strlib_get_length(flat, &length);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    size_t position = (seed >> 8) % (length + 1);
+    if (length < 1500 && (seed & 3) != 0) {
+      const char *cs = "the quick brown fox";
+      size_t len_cs = (seed >> 4) % 20;
+      bool reversed = (seed & 4) != 0;
+      ret1 = strlib_insert_chars(flat, cs, len_cs, position, reversed);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+      ret1 = strlib_insert_chars(rope, cs, len_cs, position, reversed);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+    } else if (position < length) {
+      size_t end = position + ((seed >> 4) % 40);
+      strlib_slice_t slice = {.start = position,
+                              .end = (end < length) ? end : length};
+      ret1 = strlib_remove_slice(flat, slice);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+      ret1 = strlib_remove_slice(rope, slice);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+    }
+    check_rope_matches(rope, flat);
+  }
+
+  // test typing one char after another at the same position
+  ret1 = strlib_get_length(rope, &length);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  size_t typed = length / 2;
+  for (size_t i = 0; i < 100; i++) {
+    ret1 = strlib_insert_char(flat, (char)('a' + i % 26), typed + i);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_insert_char(rope, (char)('a' + i % 26), typed + i);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  check_rope_matches(rope, flat);
+
+  // test reads of single chars and reversed slices
+  ret1 = strlib_get_length(rope, &length);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_char(rope, &c, typed);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(c == 'a');
+  ret1 = strlib_get_slice(rope, buf, sizeof(buf),
+                          (strlib_slice_t){.start = typed + 25, .end = typed});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "zyxwvutsrqponmlkjihgfedcba") == 0);
+
+  // test replacing chars in place
+  ret1 = strlib_replace_char(flat, '#', 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_char(rope, '#', 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_char(rope, '#', length);
+  assert(ret1.code == STRLIB_E_BAD_INDEX);
+  check_rope_matches(rope, flat);
+
+  // test views gather the pieces into one array
+  ret1 = strlib_get_view(rope, &view);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(view.length == length);
+  ret1 = strlib_get(flat, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(memcmp(view.chars, buf, length) == 0);
+  ret1 = strlib_compare_view(flat, view, &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(cmp == 0);
+
+  // test flat operations work on ropes and edits carry on afterwards
+  ret1 = strlib_find_char(rope, positions, &num_positions, 16, '#');
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(num_positions == 1 && positions[0] == 0);
+  ret1 = strlib_insert_chars(flat, "again", 5, 1, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(rope, "again", 5, 1, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  check_rope_matches(rope, flat);
+  ret1 = strlib_get_capacity(rope, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x > length);
+
+  // test set drops the pieces
+  ret1 = strlib_set(rope, "no longer held in the pieces", 29);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(rope, "edited and ", 11, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(rope, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "edited and no longer held in the pieces") == 0);
+  ret1 = strlib_set(rope, "short", 6);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(rope, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "short") == 0);
+  ret1 = strlib_remove_slice(rope, (strlib_slice_t){.start = 2, .end = 5});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(rope, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "sh") == 0);
+
+  ret1 = strlib_free(rope);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(flat);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+// Matches collected from a stream by collect_match.
+typedef struct {
+  strlib_slice_t slices[4096];
+  size_t num_slices;
+} match_list_t;
+
+static void collect_match(void *ctx, strlib_slice_t match) {
+  match_list_t *matches = ctx;
+  assert(matches->num_slices < 4096);
+  matches->slices[matches->num_slices++] = match;
+}
+
+static void test_stream(void) {
+  static char text[4096];
+  static strlib_slice_t expected[4096];
+  static match_list_t matches;
+  const char *patterns[] = {
+      "a", "ab", "aaa", "abcab",
+      "abababababababababababababababababababababababababababababababababab"};
+  strlib_str_t *s = NULL;
+  strlib_stream_t *stream = NULL;
+  size_t num_expected = 0;
+  uint32_t seed = 7;
+  strlib_result_t ret1;
+
+  // a small alphabet makes for many overlapping matches
+  for (size_t i = 0; i < sizeof(text) - 1; i++) {
+    seed = seed * 1103515245u + 12345u;
+    text[i] = (char)('a' + ((seed >> 16) % 3));
+    if (i % 1000 < 80) {
+      text[i] = (i % 2 == 0) ? 'a' : 'b';
+    }
+  }
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set(s, text, sizeof(text));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test chunks of every size find what searching the whole string does
+  for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+    ret1 = strlib_find_substr(s, expected, &num_expected, 4096, patterns[i]);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(num_expected > 0);
+    ret1 = strlib_stream_init(
+        &stream,
+        (strlib_view_t){.chars = patterns[i], .length = strlen(patterns[i])},
+        collect_match, &matches);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    for (size_t chunk_size = 1; chunk_size < 100; chunk_size += 7) {
+      matches.num_slices = 0;
+      ret1 = strlib_stream_reset(stream);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+      for (size_t fed = 0; fed < sizeof(text) - 1; fed += chunk_size) {
+        size_t length = sizeof(text) - 1 - fed;
+        length = (length < chunk_size) ? length : chunk_size;
+        ret1 = strlib_stream_feed(stream, text + fed, length);
+        assert(ret1.code == STRLIB_E_SUCCESS);
+        ret1 = strlib_stream_feed(stream, text + fed, 0);
+        assert(ret1.code == STRLIB_E_SUCCESS);
+      }
+      assert(matches.num_slices == num_expected);
+      assert(memcmp(matches.slices, expected,
+                    num_expected * sizeof(strlib_slice_t)) == 0);
+    }
+    ret1 = strlib_stream_free(stream);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+
+  // test an empty pattern never matches
+  matches.num_slices = 0;
+  ret1 = strlib_stream_init(&stream, (strlib_view_t){.chars = "", .length = 0},
+                            collect_match, &matches);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_stream_feed(stream, text, 100);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(matches.num_slices == 0);
+  ret1 = strlib_stream_free(stream);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static int compare_matches(const void *a, const void *b) {
+  // by end, then from the longest match to the shortest, then by pattern
+  const strlib_match_t *x = a;
+  const strlib_match_t *y = b;
+  if (x->slice.end != y->slice.end) {
+    return (x->slice.end < y->slice.end) ? -1 : 1;
+  }
+  if (x->slice.start != y->slice.start) {
+    return (x->slice.start < y->slice.start) ? -1 : 1;
+  }
+  if (x->pattern != y->pattern) return (x->pattern < y->pattern) ? -1 : 1;
+  return 0;
+}
+
+static void test_matcher(void) {
+  static char text[2048];
+  static strlib_match_t expected[8192];
+  static strlib_match_t matches[8192];
+  static strlib_slice_t slices[2048];
+  const strlib_view_t patterns[] = {
+      {.chars = "he", .length = 2},      {.chars = "she", .length = 3},
+      {.chars = "his", .length = 3},     {.chars = "hers", .length = 4},
+      {.chars = "", .length = 0},        {.chars = "she", .length = 3},
+      {.chars = "e", .length = 1},       {.chars = "s\0h", .length = 3},
+      {.chars = "hehehe", .length = 6},  {.chars = "\0", .length = 1},
+      {.chars = "rsrsrsr", .length = 7}, {.chars = "xyz", .length = 3}};
+  size_t num_patterns = sizeof(patterns) / sizeof(patterns[0]);
+  strlib_str_t *s = NULL;
+  strlib_matcher_t *matcher = NULL;
+  size_t num_expected = 0;
+  size_t num_matches = 0;
+  size_t num_slices = 0;
+  uint32_t seed = 11;
+  strlib_result_t ret1;
+
+  // a small alphabet, with a null char, makes for many overlapping matches
+  for (size_t i = 0; i < sizeof(text); i++) {
+    seed = seed * 1103515245u + 12345u;
+    text[i] = "hers\0i"[(seed >> 16) % 6];
+  }
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_view(
+      s, (strlib_view_t){.chars = text, .length = sizeof(text)}, 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i < num_patterns; i++) {
+    ret1 = strlib_find_substr_view(s, slices, &num_slices, 2048, patterns[i]);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    for (size_t j = 0; j < num_slices; j++) {
+      expected[num_expected++] =
+          (strlib_match_t){.pattern = i, .slice = slices[j]};
+    }
+  }
+  qsort(expected, num_expected, sizeof(strlib_match_t), compare_matches);
+
+  // test one pass finds what searching for every pattern does
+  ret1 = strlib_matcher_init(&matcher, patterns, num_patterns);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_matcher_find(matcher, s, matches, &num_matches, 8192);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(num_matches == num_expected);
+  assert(memcmp(matches, expected, num_expected * sizeof(strlib_match_t)) ==
+         0);
+  ret1 = strlib_matcher_find_view(
+      matcher, (strlib_view_t){.chars = text, .length = sizeof(text)}, matches,
+      &num_matches, 8192);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(num_matches == num_expected);
+
+  // test the matches buffer is not overrun
+  ret1 = strlib_matcher_find(matcher, s, matches, &num_matches, 10);
+  assert(ret1.code == STRLIB_E_BAD_SIZE);
+  assert(num_matches == 10);
+  assert(memcmp(matches, expected, 10 * sizeof(strlib_match_t)) == 0);
+
+  // test the order of matches ending at the same index
+  ret1 = strlib_matcher_find_view(
+      matcher, (strlib_view_t){.chars = "ushers", .length = 6}, matches,
+      &num_matches, 8192);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(num_matches == 5);
+  assert(matches[0].pattern == 1 && matches[0].slice.start == 1);
+  assert(matches[1].pattern == 5 && matches[1].slice.start == 1);
+  assert(matches[2].pattern == 0 && matches[2].slice.start == 2);
+  assert(matches[3].pattern == 6 && matches[3].slice.start == 3);
+  assert(matches[4].pattern == 3 && matches[4].slice.start == 2);
+  ret1 = strlib_matcher_free(matcher);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test a matcher without patterns matches nothing
+  ret1 = strlib_matcher_init(&matcher, NULL, 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_matcher_find(matcher, s, matches, &num_matches, 8192);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(num_matches == 0);
+  ret1 = strlib_matcher_free(matcher);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static size_t naive_replace_many(const char *in, const size_t length,
+                                 const strlib_view_t *needles,
+                                 const strlib_view_t *replacements,
+                                 const size_t num_pairs, char *out) {
+  // the longest needle at every index, the first of equal ones
+  size_t written = 0;
+  size_t i = 0;
+  while (i < length) {
+    size_t best = num_pairs;
+    for (size_t k = 0; k < num_pairs; k++) {
+      if (needles[k].length == 0 || needles[k].length > length - i) continue;
+      if (memcmp(in + i, needles[k].chars, needles[k].length) != 0) continue;
+      if (best == num_pairs || needles[k].length > needles[best].length) {
+        best = k;
+      }
+    }
+    if (best == num_pairs) {
+      out[written++] = in[i++];
+      continue;
+    }
+    memcpy(out + written, replacements[best].chars, replacements[best].length);
+    written += replacements[best].length;
+    i += needles[best].length;
+  }
+  return written;
+}
+
+static void test_replace_many(void) {
+  static char text[4096];
+  static char expected[16384];
+  static char buf[16384];
+  const strlib_view_t escapes[] = {
+      {.chars = "&", .length = 1}, {.chars = "<", .length = 1},
+      {.chars = ">", .length = 1}, {.chars = "\"", .length = 1}};
+  const strlib_view_t escaped[] = {
+      {.chars = "&amp;", .length = 5}, {.chars = "&lt;", .length = 4},
+      {.chars = "&gt;", .length = 4}, {.chars = "&quot;", .length = 6}};
+  const strlib_view_t needles[] = {
+      {.chars = "a", .length = 1}, {.chars = "ab", .length = 2},
+      {.chars = "abc", .length = 3}, {.chars = "bcd", .length = 3},
+      {.chars = "", .length = 0}, {.chars = "ab", .length = 2}};
+  const strlib_view_t shorter[] = {
+      {.chars = "1", .length = 1}, {.chars = "2", .length = 1},
+      {.chars = "3", .length = 1}, {.chars = "", .length = 0},
+      {.chars = "E", .length = 1}, {.chars = "6", .length = 1}};
+  const strlib_view_t longer[] = {
+      {.chars = "aa", .length = 2}, {.chars = "<ab>", .length = 4},
+      {.chars = "", .length = 0}, {.chars = "bcdbcd", .length = 6},
+      {.chars = "E", .length = 1}, {.chars = "6", .length = 1}};
+  size_t num_pairs = sizeof(needles) / sizeof(needles[0]);
+  strlib_str_t *s = NULL;
+  uint32_t seed = 5;
+  strlib_result_t ret1;
+  size_t x;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test escaping grows the string out of the inline buffer
+  ret1 = strlib_set(s, "<a href=\"x\">&</a>", 18);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_many(s, escapes, escaped, 4);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "&lt;a href=&quot;x&quot;&gt;&amp;&lt;/a&gt;") == 0);
+
+  // test the longest needle at the leftmost index is replaced in place
+  ret1 = strlib_set(s, "abcd abx ax bcd", 16);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_many(s, needles, shorter, num_pairs);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "3d 2x 1x ") == 0);
+
+  // test replacements are not matched again
+  ret1 = strlib_set(s, "aaa ab", 7);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_many(s, needles, longer, num_pairs);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "aaaaaa <ab>") == 0);
+
+  // test growing and shrinking replacements which cancel out
+  ret1 = strlib_set(s, "abb", 4);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_many(
+      s, (strlib_view_t[]){{.chars = "a", .length = 1},
+                           {.chars = "bb", .length = 2}},
+      (strlib_view_t[]){{.chars = "aa", .length = 2},
+                        {.chars = "b", .length = 1}},
+      2);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "aab") == 0);
+
+  // test shrinking a heap string back inline
+  ret1 = strlib_set(s, "abc abc abc abc abc abc abc abc", 32);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_many(s, needles, shorter, num_pairs);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "3 3 3 3 3 3 3 3") == 0);
+
+  // test random text against replacing at every index in turn
+  for (size_t i = 0; i < sizeof(text); i++) {
+    seed = seed * 1103515245u + 12345u;
+    text[i] = "abcd \0"[(seed >> 16) % 6];
+  }
+  const strlib_view_t *tables[] = {shorter, longer};
+  for (size_t t = 0; t < 2; t++) {
+    ret1 = strlib_set(s, "", 1);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_insert_view(
+        s, (strlib_view_t){.chars = text, .length = sizeof(text)}, 0);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_replace_many(s, needles, tables[t], num_pairs);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    size_t length = naive_replace_many(text, sizeof(text), needles, tables[t],
+                                       num_pairs, expected);
+    ret1 = strlib_get_length(s, &x);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(x == length);
+    ret1 = strlib_get(s, buf, sizeof(buf));
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(memcmp(buf, expected, length) == 0);
+  }
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test rope strings are replaced in
+  ret1 = strlib_init_with_representation(&s, STRLIB_REPRESENTATION_ROPE, NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, "a > b", 5, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, " & c", 4, 5, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_many(s, escapes, escaped, 4);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "a &gt; b &amp; c") == 0);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_find_iterators(void) {
+  static char text[8192];
+  static strlib_slice_t expected[8192];
+  static size_t positions[8192];
+  strlib_slices_t results = {0};
+  strlib_str_t *s = NULL;
+  strlib_finder_t *finder = NULL;
+  strlib_slice_t match;
+  size_t num_expected = 0;
+  size_t num_found = 0;
+  bool found = false;
+  uint32_t seed = 3;
+  strlib_result_t ret1;
+
+  // a small alphabet makes for many overlapping matches
+  for (size_t i = 0; i < sizeof(text) - 1; i++) {
+    seed = seed * 1103515245u + 12345u;
+    text[i] = (char)('a' + ((seed >> 16) % 3));
+  }
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set(s, text, sizeof(text));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  strlib_view_t needle = {.chars = "aba", .length = 3};
+  ret1 = strlib_find_substr_view(s, expected, &num_expected, 8192, needle);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(num_expected > 100);
+
+  // test the growable results hold every match
+  ret1 = strlib_find_all(s, &results, needle);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(results.num_slices == num_expected);
+  assert(results.capacity >= num_expected);
+  assert(memcmp(results.slices, expected,
+                num_expected * sizeof(strlib_slice_t)) == 0);
+
+  // test the iterator finds them one at a time
+  ret1 = strlib_finder_init(&finder, needle);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (;;) {
+    ret1 = strlib_find_next(finder, s, &match, &found);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    if (!found) break;
+    assert(match.start == expected[num_found].start);
+    assert(match.end == expected[num_found].end);
+    num_found++;
+  }
+  assert(num_found == num_expected);
+
+  // test seeking past every match skips the overlapping ones
+  ret1 = strlib_set(s, "abababa", 8);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_finder_seek(finder, 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  num_found = 0;
+  for (;;) {
+    ret1 = strlib_find_next(finder, s, &match, &found);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    if (!found) break;
+    assert(match.start == num_found * 4);
+    num_found++;
+    ret1 = strlib_finder_seek(finder, match.end + 1);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  assert(num_found == 2);
+  ret1 = strlib_finder_free(finder);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test chars are found in batches, reusing the results
+  ret1 = strlib_set(s, text, sizeof(text));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_find_any_char(s, positions, &num_expected, 8192, "bc");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_find_all_any_char(s, &results, "bc");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(results.num_slices == num_expected);
+  for (size_t i = 0; i < num_expected; i++) {
+    assert(results.slices[i].start == positions[i]);
+    assert(results.slices[i].end == positions[i]);
+  }
+
+  // test nothing is found by an empty needle
+  ret1 =
+      strlib_find_all(s, &results, (strlib_view_t){.chars = "", .length = 0});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(results.num_slices == 0);
+  ret1 = strlib_slices_free(&results);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(results.slices == NULL && results.capacity == 0);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_binary_safe(void) {
+  static const char frame[] = "\0\x01hdr\0body\0\0tail\0";
+  strlib_slices_t results = {0};
+  strlib_slice_t slices[8];
+  size_t positions[8];
+  strlib_str_t *s = NULL;
+  char buf[64];
+  size_t x;
+  strlib_result_t ret1;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test null characters are kept by set
+  ret1 = strlib_set_n(s, frame, sizeof(frame) - 1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == sizeof(frame) - 1);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(memcmp(buf, frame, sizeof(frame)) == 0);
+
+  // test null characters are found
+  ret1 = strlib_find_substr_n(s, slices, &x, 8, "\0\0", 2);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 1 && slices[0].start == 10 && slices[0].end == 11);
+  ret1 = strlib_find_any_char_n(s, positions, &x, 8, "\0", 1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 5 && positions[0] == 0 && positions[4] == 16);
+  ret1 = strlib_find_all_any_char_n(s, &results, "\x01\0", 2);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(results.num_slices == 6 && results.slices[1].start == 1);
+  ret1 = strlib_slices_free(&results);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test null characters are replaced and removed
+  ret1 = strlib_replace_substr_n(s, "\0\0", 2, "\0-\0", 3);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_replace_slice_n(s, "H\0", 2, (strlib_slice_t){2, 4});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_remove_substr_n(s, "\x01", 1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 16);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(memcmp(buf, "\0H\0\0body\0-\0tail\0", 17) == 0);
+  ret1 = strlib_remove_any_char_n(s, "\0-", 2);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "Hbodytail") == 0);
+
+  // test setting a rope and setting nothing
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init_with_representation(&s, STRLIB_REPRESENTATION_ROPE, NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, "a rope", 6, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set_n(s, frame, sizeof(frame) - 1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(memcmp(buf, frame, sizeof(frame)) == 0);
+  ret1 = strlib_set_n(s, NULL, 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 0);
+
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_recycling(void) {
+  static char big[4096];
+  strlib_str_t *s = NULL;
+  strlib_str_t *src = NULL;
+  char buf[64];
+  size_t capacity;
+  size_t x;
+  strlib_result_t ret1;
+
+  memset(big, 'x', sizeof(big) - 1);
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test a short value reuses the capacity of a long one
+  ret1 = strlib_set(s, big, sizeof(big));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &capacity);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set(s, "short", 6);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == capacity);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "short") == 0);
+
+  // test clearing keeps the capacity too
+  ret1 = strlib_clear(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 0);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == capacity);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "") == 0);
+
+  // test a size of 0 sets an empty string
+  ret1 = strlib_set(s, "", 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 0);
+
+  // test assigning from flat and rope strings
+  ret1 = strlib_init_with_representation(&src, STRLIB_REPRESENTATION_ROPE,
+                                         NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(src, "world", 5, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(src, "hello ", 6, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_assign_from(s, src);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "hello world") == 0);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == capacity);
+  ret1 = strlib_assign_from(src, s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(src, ",", 1, 5, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_assign_from(s, src);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_assign_from(s, s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "hello, world") == 0);
+
+  // test clearing a rope
+  ret1 = strlib_clear(src);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(src, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "") == 0);
+
+  ret1 = strlib_free(src);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_edit_batch(void) {
+  static char text[257];
+  static char expected[1024];
+  static char buf[1024];
+  const char *words[4] = {"", "x", "abc", "0123456789"};
+  strlib_edits_t *edits = NULL;
+  strlib_str_t *s = NULL;
+  strlib_str_t *reference = NULL;
+  strlib_slice_t slices[64];
+  size_t word[64];
+  bool inserts[64];
+  uint32_t seed = 12345;
+  strlib_result_t ret1;
+
+  ret1 = strlib_edits_init(&edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test an edit of each kind, added out of order
+  ret1 = strlib_set(s, "hello world", 12);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_replace(edits, (strlib_slice_t){.start = 6, .end = 10},
+                              (strlib_view_t){.chars = "there", .length = 5});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_insert(edits, 0,
+                             (strlib_view_t){.chars = ">", .length = 1});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_remove(edits, (strlib_slice_t){.start = 1, .end = 3});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_insert(edits, 11,
+                             (strlib_view_t){.chars = "!", .length = 1});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_apply_edits(s, edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, ">ho there!") == 0);
+
+  // test inserts at the same position keep their order and come before
+  // the chars replaced there, and reversed slices reverse the new chars
+  ret1 = strlib_edits_reset(edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_replace(edits, (strlib_slice_t){.start = 3, .end = 1},
+                              (strlib_view_t){.chars = "abc", .length = 3});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_insert(edits, 1,
+                             (strlib_view_t){.chars = "1", .length = 1});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_insert(edits, 1,
+                             (strlib_view_t){.chars = "2", .length = 1});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_apply_edits(s, edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, ">12cbathere!") == 0);
+
+  // test overlapping and out of bounds edits leave the string unchanged
+  ret1 = strlib_edits_reset(edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_remove(edits, (strlib_slice_t){.start = 2, .end = 4});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_insert(edits, 3,
+                             (strlib_view_t){.chars = "x", .length = 1});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_apply_edits(s, edits);
+  assert(ret1.code == STRLIB_E_BAD_INDEX);
+  ret1 = strlib_edits_reset(edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_remove(edits, (strlib_slice_t){.start = 2, .end = 13});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_apply_edits(s, edits);
+  assert(ret1.code == STRLIB_E_BAD_INDEX);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, ">12cbathere!") == 0);
+
+  // test slices may end on the null terminator, which is kept
+  ret1 = strlib_edits_reset(edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_remove(edits, (strlib_slice_t){.start = 3, .end = 12});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_apply_edits(s, edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, ">12") == 0);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test random batches on ropes match the same edits made one at a time,
+  // last to first
+  for (size_t i = 0; i < sizeof(text) - 1; i++) {
+    text[i] = (char)('a' + (char)(i % 26));
+  }
+  for (size_t round = 0; round < 50; round++) {
+    ret1 = strlib_init_with_representation(&s, STRLIB_REPRESENTATION_ROPE,
+                                           NULL);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_insert_chars(s, text + 128, 128, 0, false);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_insert_chars(s, text, 128, 0, false);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_init(&reference);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_set(reference, text, sizeof(text));
+    assert(ret1.code == STRLIB_E_SUCCESS);
+
+    size_t num_edits = 0;
+    size_t position = 0;
+    while (num_edits < 64) {
+      seed = seed * 1103515245u + 12345u;
+      position += (seed >> 8) % 8;
+      if (position > sizeof(text) - 1) break;
+      word[num_edits] = (seed >> 4) % 4;
+      inserts[num_edits] = (seed & 1) != 0;
+      if (inserts[num_edits]) {
+        slices[num_edits] =
+            (strlib_slice_t){.start = position, .end = position};
+      } else {
+        size_t end = position + ((seed >> 12) % 4);
+        if (end > sizeof(text) - 1) end = sizeof(text) - 1;
+        slices[num_edits] =
+            ((seed >> 2) & 1) != 0
+                ? (strlib_slice_t){.start = end, .end = position}
+                : (strlib_slice_t){.start = position, .end = end};
+        position = end + 1;
+      }
+      num_edits++;
+    }
+
+    ret1 = strlib_edits_reset(edits);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    for (size_t k = 0; k < num_edits; k++) {
+      // add the edits with odd indices first
+      size_t half = num_edits / 2;
+      size_t i = (k < half) ? (2 * k) + 1 : 2 * (k - half);
+      strlib_view_t view = {.chars = words[word[i]],
+                            .length = strlen(words[word[i]])};
+      if (inserts[i]) {
+        ret1 = strlib_edits_insert(edits, slices[i].start, view);
+      } else if (view.length == 0) {
+        ret1 = strlib_edits_remove(edits, slices[i]);
+      } else {
+        ret1 = strlib_edits_replace(edits, slices[i], view);
+      }
+      assert(ret1.code == STRLIB_E_SUCCESS);
+    }
+    for (size_t i = num_edits; i-- > 0;) {
+      strlib_view_t view = {.chars = words[word[i]],
+                            .length = strlen(words[word[i]])};
+      if (inserts[i]) {
+        ret1 = strlib_insert_view(reference, view, slices[i].start);
+      } else {
+        ret1 = strlib_replace_slice_view(reference, view, slices[i]);
+      }
+      assert(ret1.code == STRLIB_E_SUCCESS);
+    }
+
+    ret1 = strlib_apply_edits(s, edits);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_get(s, buf, sizeof(buf));
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_get(reference, expected, sizeof(expected));
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(strcmp(buf, expected) == 0);
+
+    ret1 = strlib_free(reference);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_free(s);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+
+  ret1 = strlib_edits_free(edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+// Values a writer alternates a shared string between, which readers must
+// only ever see whole.
+static const char *const shared_values[2] = {
+    "the quick brown fox jumps over the lazy dog",
+    "a much longer value that no longer fits inline, so that the writer "
+    "keeps moving the contents between the heap and the inline buffer",
+};
+
+static void *read_shared(void *arg) {
+  strlib_str_t *s = arg;
+  char buf[256];
+  strlib_slice_t slices[4];
+  size_t num_positions;
+  strlib_result_t ret1;
+
+  for (size_t i = 0; i < 20000; i++) {
+    ret1 = strlib_get(s, buf, sizeof(buf));
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(strcmp(buf, shared_values[0]) == 0 ||
+           strcmp(buf, shared_values[1]) == 0);
+    ret1 = strlib_find_substr(s, slices, &num_positions, 4, "long");
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(num_positions == 0 || num_positions == 2);
+  }
+  return NULL;
+}
+
+static void *write_shared(void *arg) {
+  strlib_str_t *s = arg;
+  strlib_result_t ret1;
+
+  for (size_t i = 0; i < 20000; i++) {
+    const char *value = shared_values[i % 2];
+    ret1 = strlib_set(s, value, strlen(value) + 1);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  return NULL;
+}
+
+// Pair of shared strings assigned to each other from two threads.
+typedef struct {
+  strlib_str_t *to;
+  strlib_str_t *from;
+} assign_args_t;
+
+static void *assign_shared(void *arg) {
+  assign_args_t *args = arg;
+  strlib_result_t ret1;
+
+  for (size_t i = 0; i < 20000; i++) {
+    ret1 = strlib_assign_from(args->to, args->from);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  return NULL;
+}
+
+static void test_shared(void) {
+  strlib_str_t *s = NULL;
+  strlib_str_t *rope = NULL;
+  pthread_t threads[4];
+  char buf[256];
+  int rc;
+  strlib_result_t ret1;
+
+  // test readers only ever see whole values while a writer replaces them
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_share(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_share(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set(s, shared_values[0], strlen(shared_values[0]) + 1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i < 3; i++) {
+    rc = pthread_create(&threads[i], NULL, read_shared, s);
+    assert(rc == 0);
+  }
+  rc = pthread_create(&threads[3], NULL, write_shared, s);
+  assert(rc == 0);
+  for (size_t i = 0; i < 4; i++) {
+    rc = pthread_join(threads[i], NULL);
+    assert(rc == 0);
+  }
+
+  // test operations calling others on the same string, and assigning a
+  // string to itself, do not lock it twice
+  ret1 = strlib_remove_char(s, 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_assign_from(s, s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, shared_values[1] + 1) == 0);
+
+  // test two shared ropes assigned to each other from two threads
+  ret1 = strlib_init_with_representation(&rope, STRLIB_REPRESENTATION_ROPE,
+                                         NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_share(rope);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(rope, "rope", 4, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(rope, "shared ", 7, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assign_args_t args[2] = {{.to = s, .from = rope}, {.to = rope, .from = s}};
+  rc = pthread_create(&threads[0], NULL, assign_shared, &args[0]);
+  assert(rc == 0);
+  rc = pthread_create(&threads[1], NULL, assign_shared, &args[1]);
+  assert(rc == 0);
+  for (size_t i = 0; i < 2; i++) {
+    rc = pthread_join(threads[i], NULL);
+    assert(rc == 0);
+  }
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "shared rope") == 0 ||
+         strcmp(buf, shared_values[1] + 1) == 0);
+
+  ret1 = strlib_free(rope);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+// Writes `length` chars to a new temporary file whose path is left in
+// `path`, which must hold the template "/tmp/strlib-XXXXXX".
+static void write_temp_file(char *path, const char *chars,
+                            const size_t length) {
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  size_t written = 0;
+  while (written < length) {
+    ssize_t n = write(fd, chars + written, length - written);
+    assert(n > 0);
+    written += (size_t)n;
+  }
+  close(fd);
+}
+
+static void test_mapped(void) {
+  static char text[8192];
+  static char buf[8192];
+  static char expected[8192];
+  char path[] = "/tmp/strlib-XXXXXX";
+  char empty_path[] = "/tmp/strlib-XXXXXX";
+  strlib_str_t *s = NULL;
+  strlib_str_t *flat = NULL;
+  strlib_edits_t *edits = NULL;
+  strlib_slice_t slices[4];
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t x;
+  strlib_result_t ret1;
+
+  // a file filling its last page exactly still reads null terminated
+  assert(page <= sizeof(text) - 1);
+  for (size_t i = 0; i < page; i++) {
+    text[i] = (char)('a' + (char)(i % 26));
+  }
+  memcpy(text + 100, "needle", 6);
+  write_temp_file(path, text, page);
+
+  // test reads come straight from the mapping
+  ret1 = strlib_init_from_file(&s, path, NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == page);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 0);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(memcmp(buf, text, page) == 0 && buf[page] == '\0');
+  ret1 = strlib_find_substr(s, slices, &x, 4, "needle");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 1 && slices[0].start == 100);
+  ret1 = strlib_remove_substr(s, "absent");
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_shrink_to_fit(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 0);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test every kind of modification copies the contents out first and
+  // matches the same modification of a flat string
+  ret1 = strlib_edits_init(&edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_edits_replace(edits, (strlib_slice_t){.start = 1, .end = 2},
+                              (strlib_view_t){.chars = "xyz", .length = 3});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t op = 0; op < 10; op++) {
+    ret1 = strlib_init_from_file(&s, path, NULL);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_init(&flat);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_set_n(flat, text, page);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    strlib_str_t *targets[2] = {s, flat};
+    for (size_t i = 0; i < 2; i++) {
+      strlib_str_t *t = targets[i];
+      strlib_view_t needle = {.chars = "needle", .length = 6};
+      strlib_view_t pin = {.chars = "pin", .length = 3};
+      strlib_slice_t slice = {.start = 3, .end = 7};
+      switch (op) {
+        case 0:
+          ret1 = strlib_replace_char(t, 'Z', 0);
+          break;
+        case 1:
+          ret1 = strlib_insert_chars(t, "hello", 5, 10, false);
+          break;
+        case 2:
+          ret1 = strlib_remove_slice(t, slice);
+          break;
+        case 3:
+          ret1 = strlib_replace_substr(t, "needle", "pin");
+          break;
+        case 4:
+          ret1 = strlib_replace_substr(t, "needle", "longer needle");
+          break;
+        case 5:
+          ret1 = strlib_remove_substr(t, "abc");
+          break;
+        case 6:
+          ret1 = strlib_remove_slices(t, &slice, 1);
+          break;
+        case 7:
+          ret1 = strlib_remove_any_char(t, "xyz");
+          break;
+        case 8:
+          ret1 = strlib_replace_many(t, &needle, &pin, 1);
+          break;
+        default:
+          ret1 = strlib_apply_edits(t, edits);
+          break;
+      }
+      assert(ret1.code == STRLIB_E_SUCCESS);
+    }
+    ret1 = strlib_get_capacity(s, &x);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(x != 0);
+    ret1 = strlib_get(s, buf, sizeof(buf));
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_get(flat, expected, sizeof(expected));
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(strcmp(buf, expected) == 0);
+    ret1 = strlib_free(flat);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_free(s);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  ret1 = strlib_edits_free(edits);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test the file itself is never written
+  FILE *file = fopen(path, "rb");
+  assert(file != NULL);
+  assert(fread(buf, 1, sizeof(buf), file) == page);
+  fclose(file);
+  assert(memcmp(buf, text, page) == 0);
+
+  // test setting and clearing drop the mapping
+  ret1 = strlib_init_from_file(&s, path, NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set(s, "short", 6);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "short") == 0);
+  int fd = open(path, O_RDONLY);
+  assert(fd >= 0);
+  ret1 = strlib_map(s, fd);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_clear(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "") == 0);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test ropes copy mapped contents out on their first edit
+  ret1 = strlib_init_with_representation(&s, STRLIB_REPRESENTATION_ROPE,
+                                         NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_map(s, fd);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  close(fd);
+  ret1 = strlib_insert_chars(s, "<>", 2, page / 2, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(memcmp(buf, text, page / 2) == 0);
+  assert(memcmp(buf + (page / 2), "<>", 2) == 0);
+  assert(strcmp(buf + (page / 2) + 2, text + (page / 2)) == 0);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test empty files, missing files and directories
+  write_temp_file(empty_path, "", 0);
+  ret1 = strlib_init_from_file(&s, empty_path, NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 0);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  unlink(empty_path);
+  ret1 = strlib_init_from_file(&s, empty_path, NULL);
+  assert(ret1.code == STRLIB_E_IO);
+  assert(s == NULL);
+  ret1 = strlib_init_from_file(&s, "/tmp", NULL);
+  assert(ret1.code == STRLIB_E_IO);
+  assert(s == NULL);
+
+  unlink(path);
+}
+
+// Table and names interned into it by several threads at once.
+typedef struct {
+  strlib_intern_t *table;
+  const strlib_str_t **interned;
+  size_t first;
+} intern_args_t;
+
+static void *intern_names(void *arg) {
+  intern_args_t *args = arg;
+  char name[32];
+  strlib_result_t ret1;
+
+  // threads start at different names, so they race on every one of them
+  for (size_t k = 0; k < 2000; k++) {
+    size_t i = (args->first + k) % 2000;
+    int length = snprintf(name, sizeof(name), "host-%zu.example", i);
+    ret1 = strlib_intern(args->table,
+                         (strlib_view_t){.chars = name,
+                                         .length = (size_t)length},
+                         &args->interned[i]);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  return NULL;
+}
+
+static void test_intern(void) {
+  static const strlib_str_t *interned[4][2000];
+  strlib_intern_t *table = NULL;
+  strlib_str_t *s = NULL;
+  const strlib_str_t *a = NULL;
+  const strlib_str_t *b = NULL;
+  const strlib_str_t *c = NULL;
+  pthread_t threads[4];
+  intern_args_t args[4];
+  char buf[64];
+  size_t x;
+  int rc;
+  strlib_result_t ret1;
+
+  ret1 = strlib_intern_init(&table);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test equal contents give the same string, others another one
+  ret1 = strlib_intern(table, (strlib_view_t){.chars = "host", .length = 4},
+                       &a);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_intern(table, (strlib_view_t){.chars = "hostname", .length = 4},
+                       &b);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(a == b);
+  ret1 = strlib_intern(table, (strlib_view_t){.chars = "hosT", .length = 4},
+                       &c);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(a != c);
+  ret1 = strlib_get(a, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "host") == 0);
+
+  // test empty and binary contents
+  ret1 = strlib_intern(table, (strlib_view_t){.chars = NULL, .length = 0}, &a);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_intern(table, (strlib_view_t){.chars = "", .length = 0}, &b);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(a == b);
+  ret1 = strlib_get_length(a, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == 0);
+  ret1 = strlib_intern(table, (strlib_view_t){.chars = "a\0b", .length = 3},
+                       &a);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_intern(table, (strlib_view_t){.chars = "a\0c", .length = 3},
+                       &b);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(a != b);
+
+  // test interning the contents of long rope strings
+  ret1 = strlib_init_with_representation(&s, STRLIB_REPRESENTATION_ROPE,
+                                         NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, "example.com", 11, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, "a-rather-long-host-name.", 24, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_intern_str(table, s, &a);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_intern(
+      table,
+      (strlib_view_t){.chars = "a-rather-long-host-name.example.com",
+                      .length = 35},
+      &b);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(a == b);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(a, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "a-rather-long-host-name.example.com") == 0);
+
+  // test threads interning the same names get the same strings
+  for (size_t i = 0; i < 4; i++) {
+    args[i] = (intern_args_t){
+        .table = table,
+        .interned = interned[i],
+        .first = i * 500,
+    };
+    rc = pthread_create(&threads[i], NULL, intern_names, &args[i]);
+    assert(rc == 0);
+  }
+  for (size_t i = 0; i < 4; i++) {
+    rc = pthread_join(threads[i], NULL);
+    assert(rc == 0);
+  }
+  for (size_t i = 0; i < 2000; i++) {
+    assert(interned[0][i] != NULL);
+    for (size_t j = 1; j < 4; j++) {
+      assert(interned[j][i] == interned[0][i]);
+    }
+    if (i > 0) assert(interned[0][i] != interned[0][i - 1]);
+  }
+  ret1 = strlib_get(interned[0][1234], buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "host-1234.example") == 0);
+
+  ret1 = strlib_intern_free(table);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_hash(void) {
+  static char text[4096];
+  char path[] = "/tmp/strlib-XXXXXX";
+  strlib_intern_t *table = NULL;
+  strlib_str_t *s = NULL;
+  strlib_str_t *r = NULL;
+  strlib_str_t *m = NULL;
+  const strlib_str_t *interned = NULL;
+  uint64_t hash;
+  uint64_t expected;
+  int fd;
+  strlib_result_t ret1;
+
+  for (size_t i = 0; i < sizeof(text); i++) {
+    text[i] = (char)('a' + ((i * 7) % 26));
+  }
+
+  // test every tail length hashes equally as a view and as a string
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i <= 100; i++) {
+    ret1 = strlib_set_n(s, text, i);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_hash(s, &hash);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_hash_view((strlib_view_t){.chars = text, .length = i},
+                            &expected);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(hash == expected);
+    if (i > 0) {
+      ret1 = strlib_hash_view(
+          (strlib_view_t){.chars = text + 1, .length = i}, &hash);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+      assert(hash != expected);
+    }
+  }
+
+  // test the cached hash follows insertions, removals, sets and clears
+  ret1 = strlib_set_n(s, "hello", 5);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(s, &expected);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, ", world", 7, 5, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(s, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(hash != expected);
+  ret1 = strlib_remove_slice(s, (strlib_slice_t){.start = 5, .end = 11});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(s, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(hash == expected);
+  ret1 = strlib_set(s, "help!", 5);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(s, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(hash != expected);
+  ret1 = strlib_clear(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(s, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash_view((strlib_view_t){.chars = NULL, .length = 0},
+                          &expected);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(hash == expected);
+
+  // test ropes, mapped files and interned strings hash as flat strings do
+  ret1 = strlib_set_n(s, text, sizeof(text));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(s, &expected);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init_with_representation(&r, STRLIB_REPRESENTATION_ROPE,
+                                         NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(r, text + 2048, 2048, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(r, text, 2048, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(r, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(hash == expected);
+  write_temp_file(path, text, sizeof(text));
+  fd = open(path, O_RDONLY);
+  assert(fd >= 0);
+  ret1 = strlib_init(&m);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_map(m, fd);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  close(fd);
+  unlink(path);
+  ret1 = strlib_hash(m, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(hash == expected);
+  ret1 = strlib_intern_init(&table);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_intern_str(table, m, &interned);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(interned, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(hash == expected);
+
+  ret1 = strlib_intern_free(table);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(m);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(r);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+// Orders strlib strings for qsort, as the reference strlib_sort is checked
+// against.
+static int compare_strs(const void *a, const void *b) {
+  int cmp = 0;
+  strlib_result_t ret1 = strlib_compare(*(strlib_str_t *const *)a,
+                                        *(strlib_str_t *const *)b, &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  return cmp;
+}
+
+static void test_compare(void) {
+  static strlib_str_t *strs[3000];
+  static strlib_str_t *expected[3000];
+  static char text[96];
+  strlib_str_t *s = NULL;
+  strlib_str_t *t = NULL;
+  strlib_str_t *r = NULL;
+  pthread_t threads[2];
+  uint32_t seed = 99;
+  int rc;
+  uint64_t hash;
+  bool equal;
+  int cmp;
+  strlib_result_t ret1;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init(&t);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init_with_representation(&r, STRLIB_REPRESENTATION_ROPE,
+                                         NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test ordering by unsigned bytes, with a prefix first
+  ret1 = strlib_set_n(s, "abc", 3);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set_n(t, "abc\xff", 4);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_compare(s, t, &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(cmp == -1);
+  ret1 = strlib_compare(t, s, &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(cmp == 1);
+  ret1 = strlib_compare(s, s, &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(cmp == 0);
+  ret1 = strlib_set_n(t, "ab\x80", 3);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_compare(s, t, &cmp);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(cmp == -1);
+
+  // test equality of strings, ropes and views, with and without hashes
+  ret1 = strlib_insert_chars(r, "c", 1, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(r, "ab", 2, 0, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_equals(s, r, &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(equal);
+  ret1 = strlib_equals(s, t, &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(!equal);
+  ret1 = strlib_hash(s, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(t, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_equals(s, t, &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(!equal);
+  ret1 = strlib_set_n(t, "abc", 3);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_hash(t, &hash);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_equals(t, s, &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(equal);
+  ret1 = strlib_equals_view(s, (strlib_view_t){.chars = "abc", .length = 3},
+                            &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(equal);
+  ret1 = strlib_equals_view(s, (strlib_view_t){.chars = "abd", .length = 3},
+                            &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(!equal);
+  ret1 = strlib_equals_view(s, (strlib_view_t){.chars = "abc", .length = 2},
+                            &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(!equal);
+
+  // test prefixes and suffixes, empty ones included
+  ret1 = strlib_starts_with(r, (strlib_view_t){.chars = "ab", .length = 2},
+                            &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(equal);
+  ret1 = strlib_starts_with(r, (strlib_view_t){.chars = "bc", .length = 2},
+                            &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(!equal);
+  ret1 = strlib_ends_with(r, (strlib_view_t){.chars = "bc", .length = 2},
+                          &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(equal);
+  ret1 = strlib_ends_with(r, (strlib_view_t){.chars = "abcd", .length = 4},
+                          &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(!equal);
+  ret1 = strlib_clear(t);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_starts_with(t, (strlib_view_t){.chars = NULL, .length = 0},
+                            &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(equal);
+  ret1 = strlib_ends_with(t, (strlib_view_t){.chars = NULL, .length = 0},
+                          &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(equal);
+
+  // test sorting random keys sharing long prefixes, with duplicates, null
+  // chars and every one a prefix of some other, matches qsort
+  for (size_t i = 0; i < sizeof(text); i++) text[i] = "ab\0"[i % 3];
+  for (size_t i = 0; i < 3000; i++) {
+    seed = seed * 1103515245u + 12345u;
+    size_t common = ((seed >> 8) % 4) * 20;
+    size_t length = common + ((seed >> 12) % 16);
+    if (i % 10 == 0) {
+      ret1 = strlib_init_with_representation(
+          &strs[i], STRLIB_REPRESENTATION_ROPE, NULL);
+    } else {
+      ret1 = strlib_init(&strs[i]);
+    }
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    ret1 = strlib_insert_chars(strs[i], text, common, 0, false);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    for (size_t j = common; j < length; j++) {
+      seed = seed * 1103515245u + 12345u;
+      ret1 = strlib_insert_char(strs[i], "ab\0\xff"[(seed >> 16) % 4], j);
+      assert(ret1.code == STRLIB_E_SUCCESS);
+    }
+    expected[i] = strs[i];
+  }
+  qsort(expected, 3000, sizeof(strlib_str_t *), compare_strs);
+  ret1 = strlib_sort(strs, 3000);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  for (size_t i = 0; i < 3000; i++) {
+    ret1 = strlib_compare(strs[i], expected[i], &cmp);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    assert(cmp == 0);
+  }
+
+  // test sorting nothing, one string and a few
+  ret1 = strlib_sort(NULL, 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_sort(strs, 1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  expected[0] = s;
+  expected[1] = t;
+  expected[2] = r;
+  ret1 = strlib_sort(expected, 3);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(expected[0] == t);
+
+  // test sorting shared strings, listed twice, while others write them
+  for (size_t i = 0; i < 40; i++) {
+    ret1 = strlib_share(strs[i]);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+    expected[i] = strs[i];
+    expected[40 + i] = strs[i];
+  }
+  for (size_t i = 0; i < 2; i++) {
+    rc = pthread_create(&threads[i], NULL, write_shared, strs[i * 10]);
+    assert(rc == 0);
+  }
+  for (size_t i = 0; i < 200; i++) {
+    ret1 = strlib_sort(expected, 80);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  for (size_t i = 0; i < 2; i++) {
+    rc = pthread_join(threads[i], NULL);
+    assert(rc == 0);
+  }
+
+  for (size_t i = 0; i < 3000; i++) {
+    ret1 = strlib_free(strs[i]);
+    assert(ret1.code == STRLIB_E_SUCCESS);
+  }
+  ret1 = strlib_free(r);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(t);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static void test_concat(void) {
+  static char expected[4096];
+  char buf[256];
+  strlib_str_t *s = NULL;
+  strlib_str_t *r = NULL;
+  strlib_view_t parts[64];
+  size_t x;
+  bool equal;
+  strlib_result_t ret1;
+
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init_with_representation(&r, STRLIB_REPRESENTATION_ROPE,
+                                         NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test appending views, strings and strings to themselves
+  ret1 = strlib_append(s, (strlib_view_t){.chars = "ab", .length = 2});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_append(s, (strlib_view_t){.chars = NULL, .length = 0});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_append_str(r, s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_append_str(s, s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_append_str(r, s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_append_str(r, r);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "abab") == 0);
+  ret1 = strlib_get(r, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "abababababab") == 0);
+
+  // test concatenating grows exactly once to the total length
+  ret1 = strlib_clear(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_shrink_to_fit(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set_growth_policy(
+      s, (strlib_growth_policy_t){.strategy = STRLIB_GROWTH_EXACT});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  x = 0;
+  for (size_t i = 0; i < 64; i++) {
+    parts[i] = (strlib_view_t){.chars = "fragment-of-a-response;",
+                               .length = i % 24};
+    memcpy(expected + x, parts[i].chars, parts[i].length);
+    x += parts[i].length;
+  }
+  expected[x] = '\0';
+  ret1 = strlib_concat(s, parts, 64);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_capacity(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == strlen(expected) + 1);
+  ret1 = strlib_equals_view(
+      s, (strlib_view_t){.chars = expected, .length = strlen(expected)},
+      &equal);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(equal);
+  ret1 = strlib_concat(s, NULL, 0);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_length(s, &x);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(x == strlen(expected));
+
+  // test concatenating null terminated arrays onto flat strings and ropes
+  ret1 = strlib_set(s, "HTTP/1.1 ", 10);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_concat_cstrs(s, "200", " ", "", "OK", "\r\n", NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "HTTP/1.1 200 OK\r\n") == 0);
+  ret1 = strlib_concat_cstrs(r, "|", "rope", NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(r, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "abababababab|rope") == 0);
+  ret1 = strlib_concat_cstrs(r, NULL);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+  // test joining puts separators only between parts
+  parts[0] = (strlib_view_t){.chars = "a", .length = 1};
+  parts[1] = (strlib_view_t){.chars = NULL, .length = 0};
+  parts[2] = (strlib_view_t){.chars = "ccc", .length = 3};
+  ret1 = strlib_clear(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_join(s, (strlib_view_t){.chars = ", ", .length = 2}, parts,
+                     3);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "a, , ccc") == 0);
+  ret1 = strlib_join(s, (strlib_view_t){.chars = ", ", .length = 2}, parts,
+                     1);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_join(r, (strlib_view_t){.chars = "/", .length = 1}, parts, 3);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "a, , ccca") == 0);
+  ret1 = strlib_get(r, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "abababababab|ropea//ccc") == 0);
+
+  // test lengths overflowing the size error without changing the string
+  parts[0] = (strlib_view_t){.chars = "a", .length = SIZE_MAX - 2};
+  parts[1] = (strlib_view_t){.chars = "a", .length = 2};
+  ret1 = strlib_concat(s, parts, 2);
+  assert(ret1.code == STRLIB_E_NO_MEMORY);
+  ret1 = strlib_join(s, (strlib_view_t){.chars = "-", .length = 1}, parts,
+                     2);
+  assert(ret1.code == STRLIB_E_NO_MEMORY);
+  ret1 = strlib_get(s, buf, sizeof(buf));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(strcmp(buf, "a, , ccca") == 0);
+
+  ret1 = strlib_free(r);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+}
+
+static const strlib_operation_stats_t *find_operation(
+    const strlib_stats_t *stats, const char *name) {
+  for (size_t i = 0; i < stats->num_operations; i++) {
+    if (strcmp(stats->operations[i].name, name) == 0) {
+      return &stats->operations[i];
+    }
+  }
+  return NULL;
+}
+
+static void test_stats(void) {
+  strlib_str_t *s = NULL;
+  strlib_stats_t stats;
+  strlib_result_t ret1;
+
+  ret1 = strlib_reset_stats();
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set(s, "a string which does not fit inline", 35);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_insert_chars(s, "(moved to make room) ", 21, 2, false);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_stats(&stats);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+
+#ifdef STRLIB_INSTRUMENT
+  // test the operations, allocations and bytes are counted
+  assert(stats.enabled);
+  assert(find_operation(&stats, "strlib_init")->calls == 1);
+  // nested calls are counted only by the public function called
+  assert(find_operation(&stats, "strlib_init_with_allocator")->calls == 0);
+  assert(find_operation(&stats, "strlib_set")->calls == 1);
+  assert(find_operation(&stats, "strlib_insert_chars")->calls == 1);
+  assert(find_operation(&stats, "strlib_free")->calls == 1);
+  assert(find_operation(&stats, "strlib_get")->calls == 0);
+  assert(stats.allocations == 2);
+  assert(stats.reallocations == 1);
+  assert(stats.releases == 2);
+  // the chars set and inserted, and the terminator copied out of the
+  // inline buffer
+  assert(stats.bytes_copied == 56);
+  // the tail shifted by the insert, including the terminator
+  assert(stats.bytes_moved == 33);
+
+  // test resetting starts over
+  ret1 = strlib_reset_stats();
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_stats(&stats);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(stats.allocations == 0);
+  assert(find_operation(&stats, "strlib_set")->calls == 0);
+
+  // test setting more than fits copies the new chars only, never the old
+  static char text[5000];
+  memset(text, 'x', sizeof(text));
+  ret1 = strlib_init(&s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set_growth_policy(
+      s, (strlib_growth_policy_t){.strategy = STRLIB_GROWTH_EXACT});
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set_n(s, text, 4096);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_reset_stats();
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_set_n(s, text, sizeof(text));
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  ret1 = strlib_get_stats(&stats);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+  assert(stats.reallocations == 0);
+  assert(stats.allocations == 1);
+  assert(stats.releases == 1);
+  assert(stats.bytes_copied == sizeof(text));
+  ret1 = strlib_free(s);
+  assert(ret1.code == STRLIB_E_SUCCESS);
+#else
+  // test nothing is gathered unless instrumented
+  assert(!stats.enabled);
+  assert(stats.num_operations == 0);
+  assert(find_operation(&stats, "strlib_set") == NULL);
+#endif
+}
+
 /*static void test_specific_example(void) {
   strlib_str_t *s = NULL;
   char buf[256] = {0};
@@ -207,7 +2631,7 @@ static void test_string_operations(void) {
 
   ret1 = strlib_init(&s);
   assert(ret1.code == STRLIB_E_SUCCESS);
-  ret1 = strlib_set(s, "foobarrrrabbarr", 15);
+  ret1 = strlib_set(s, "foobarrrrabbarr", 16);
   ret1 = strlib_replace_substr(s, "barr", "baz");
   assert(ret1.code == STRLIB_E_SUCCESS);
   ret1 = strlib_get(s, buf, 256);
@@ -226,5 +2650,53 @@ int main(void) {
   printf("test_char_operations() passed!\n");
   test_string_operations();
   printf("test_string_operations() passed!\n");
+  test_small_string();
+  printf("test_small_string() passed!\n");
+  test_growth_policy();
+  printf("test_growth_policy() passed!\n");
+  test_allocators();
+  printf("test_allocators() passed!\n");
+  test_views();
+  printf("test_views() passed!\n");
+  test_search_engine();
+  printf("test_search_engine() passed!\n");
+  test_char_scan();
+  printf("test_char_scan() passed!\n");
+  test_replace_substr();
+  printf("test_replace_substr() passed!\n");
+  test_remove_compaction();
+  printf("test_remove_compaction() passed!\n");
+  test_block_moves();
+  printf("test_block_moves() passed!\n");
+  test_rope();
+  printf("test_rope() passed!\n");
+  test_stats();
+  printf("test_stats() passed!\n");
+  test_stream();
+  printf("test_stream() passed!\n");
+  test_matcher();
+  printf("test_matcher() passed!\n");
+  test_replace_many();
+  printf("test_replace_many() passed!\n");
+  test_find_iterators();
+  printf("test_find_iterators() passed!\n");
+  test_binary_safe();
+  printf("test_binary_safe() passed!\n");
+  test_recycling();
+  printf("test_recycling() passed!\n");
+  test_edit_batch();
+  printf("test_edit_batch() passed!\n");
+  test_shared();
+  printf("test_shared() passed!\n");
+  test_mapped();
+  printf("test_mapped() passed!\n");
+  test_intern();
+  printf("test_intern() passed!\n");
+  test_hash();
+  printf("test_hash() passed!\n");
+  test_compare();
+  printf("test_compare() passed!\n");
+  test_concat();
+  printf("test_concat() passed!\n");
   return 0;
 }
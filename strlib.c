@@ -1,9 +1,28 @@
 #include "strlib.h"
 
 #include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef STRLIB_INSTRUMENT
+#include <time.h>
+#endif
+
+// x86-64 always provides SSE2; wider kernels are picked at runtime.
+#if defined(__x86_64__) && !defined(STRLIB_NO_SIMD)
+#define STRLIB_X86_SIMD
+#include <immintrin.h>
+#endif
 
 /*******************************************************************************/
 
@@ -13,292 +32,5059 @@
 
 // This is the internal representation of the strlib_str_t
 // type, which is given to primitive functions.
+// Short contents live in `small` and `chars` points at it; longer contents
+// move to a heap buffer once they outgrow STRLIB_SMALL_CAPACITY. Rope strings
+// also own a `rope`, which holds the contents instead while it is active.
+// Shared strings own a `lock`, taken by every public operation on them.
+// Mapped strings read their contents from a private read-only mapping of
+// `map_size` bytes at `chars`, which is copied to the heap once modified.
+// `hash` caches the hash of the contents, or is 0 until it is computed. It
+// is atomic as readers of shared strings may store it concurrently.
 struct strlib_str_t {
   size_t length;
   size_t capacity;
   char *chars;
+  strlib_growth_policy_t growth;
+  const strlib_allocator_t *allocator;
+  struct strlib_rope_t *rope;
+  pthread_rwlock_t *lock;
+  size_t map_size;
+  atomic_ullong hash;
+  char small[STRLIB_SMALL_CAPACITY];
+};
+
+// A block of memory owned by an arena. The usable bytes follow the header.
+typedef struct strlib_arena_block_t {
+  struct strlib_arena_block_t *next;
+  size_t size;
+  size_t used;
+} strlib_arena_block_t;
+
+// Internal representation of the strlib_arena_t type. Blocks are kept across
+// resets; `current` is the block being bumped and `last` the most recent
+// allocation, which is the only one that can be resized or released in place.
+struct strlib_arena_t {
+  strlib_allocator_t allocator;
+  strlib_arena_block_t *blocks;
+  strlib_arena_block_t *current;
+  strlib_arena_block_t *tail;
+  size_t block_size;
+  char *last;
+};
+
+// A chunk of objects owned by a pool. The objects follow the header.
+typedef struct strlib_pool_chunk_t {
+  struct strlib_pool_chunk_t *next;
+} strlib_pool_chunk_t;
+
+// Internal representation of the strlib_pool_t type. Free objects are linked
+// through their first word.
+struct strlib_pool_t {
+  strlib_allocator_t allocator;
+  strlib_pool_chunk_t *chunks;
+  void *free_list;
+  size_t object_size;
+  size_t objects_per_chunk;
+};
+
+// A piece of a rope string: `length` chars borrowed from one of the rope's
+// buffers. Pieces form a treap ordered by position and heap ordered by
+// `priority`, and `size` counts the chars of the piece's whole subtree.
+typedef struct strlib_rope_node_t {
+  struct strlib_rope_node_t *left;
+  struct strlib_rope_node_t *right;
+  const char *chars;
+  size_t length;
+  size_t size;
+  uint32_t priority;
+} strlib_rope_node_t;
+
+// An append-only block holding chars inserted into a rope. Blocks never move,
+// so pieces point straight into them. The chars follow the header.
+typedef struct strlib_rope_block_t {
+  struct strlib_rope_block_t *next;
+  size_t size;
+  size_t used;
+} strlib_rope_block_t;
+
+// Internal representation of a rope. While `active`, the contents of the
+// string are the pieces under `root`, which borrow from `base` (the flat
+// buffer taken over from the string) and from `blocks`, newest first.
+// Otherwise the string holds its contents flat like any other. Nodes dropped
+// from the tree are kept on `free_nodes`, linked through `left`.
+typedef struct strlib_rope_t {
+  strlib_rope_node_t *root;
+  strlib_rope_node_t *free_nodes;
+  size_t num_free_nodes;
+  strlib_rope_block_t *blocks;
+  char *base;
+  size_t base_size;
+  size_t bytes;
+  uint32_t seed;
+  bool active;
+} strlib_rope_t;
+
+// Bounds on the size of the blocks chars inserted into a rope are copied to.
+#define STRLIB_ROPE_MIN_BLOCK_SIZE 256
+#define STRLIB_ROPE_MAX_BLOCK_SIZE 65536
+
+// Position reported by searches which found nothing.
+#define STRLIB_NOT_FOUND SIZE_MAX
+
+// Needle length above which substring search switches to Two-Way.
+#define STRLIB_TWO_WAY_THRESHOLD 64
+
+// A substring search prepared once per needle. Short needles run a first and
+// last char filter, long ones the Two-Way algorithm using the critical
+// factorization stored in `critical` and its shift `period`.
+typedef struct strlib_search_t {
+  const char *needle;
+  size_t length;
+  size_t (*kernel)(const struct strlib_search_t *search, const char *chars,
+                   size_t length, size_t from);
+  size_t critical;
+  size_t period;
+  bool periodic;
+} strlib_search_t;
+
+// Internal representation of the strlib_stream_t type. The last `carried`
+// chars fed, always fewer than the pattern, are kept in `carry` so that
+// matches spanning chunks can be found by joining them with the start of
+// the next chunk in `scratch`. The pattern, carry and scratch buffers follow
+// the header in a single allocation of `size` bytes.
+struct strlib_stream_t {
+  strlib_search_t search;
+  strlib_match_callback_t callback;
+  void *ctx;
+  size_t offset;
+  size_t carried;
+  char *carry;
+  char *scratch;
+  size_t size;
+};
+
+// Internal representation of the strlib_finder_t type. The needle follows
+// the header in a single allocation of `size` bytes.
+struct strlib_finder_t {
+  strlib_search_t search;
+  size_t position;
+  size_t size;
+};
+
+// Marks a missing state, pattern or output of a multi-pattern matcher.
+#define STRLIB_MATCHER_NONE UINT32_MAX
+
+// Patterns matched at a state of a multi-pattern matcher: `count` pattern
+// indices from `start` in the matcher's `ids`, then those of output `link`,
+// the longest proper suffix of the state at which patterns end.
+typedef struct {
+  uint32_t start;
+  uint32_t count;
+  uint32_t link;
+} strlib_matcher_output_t;
+
+// Internal representation of the strlib_matcher_t type, an Aho-Corasick
+// automaton compiled to a DFA. Bytes are mapped to `num_classes` classes,
+// one per byte used by the patterns and one for all others, and `next`
+// holds a row of transitions per state, storing the offset of the target
+// row rather than its number. States at which patterns match are numbered
+// last, from `first_output`, so a single compare tells them apart. The
+// arrays follow the header in a single allocation of `size` bytes.
+struct strlib_matcher_t {
+  uint16_t classes[UCHAR_MAX + 1];
+  size_t num_classes;
+  size_t num_states;
+  size_t first_output;
+  size_t *lengths;
+  uint32_t *next;
+  strlib_matcher_output_t *outputs;
+  uint32_t *ids;
+  size_t size;
+};
+
+// Scratch used while compiling a matcher. `trie` holds rows of edges, where
+// 0 marks a missing edge as the root is no child, and every other array has
+// an entry per state but `same`, which has one per pattern.
+typedef struct {
+  uint32_t *trie;    // Edges of the trie, then of the automaton.
+  uint32_t *fail;    // Longest proper suffix of the state in the trie.
+  uint32_t *order;   // States in breadth first order.
+  uint32_t *first;   // First pattern ending at the state.
+  uint32_t *same;    // Next pattern ending at the state a pattern ends at.
+  uint32_t *link;    // Longest proper suffix at which patterns end.
+  uint32_t *number;  // Number of the state in the compiled matcher.
+  size_t num_states;
+  size_t trie_size;
+  size_t scratch_size;
+} strlib_matcher_build_t;
+
+// Number of distinct bytes a byte set compares with vectors.
+#define STRLIB_BYTE_SET_SIMD_LIMIT 8
+
+// A set of bytes scanned for at once. `member` flags every byte of the set,
+// and the first STRLIB_BYTE_SET_SIMD_LIMIT distinct ones are kept in `bytes`
+// for vector compares. `kernel` stores the positions of all members.
+typedef struct strlib_byte_set_t {
+  unsigned char bytes[STRLIB_BYTE_SET_SIMD_LIMIT];
+  size_t num_bytes;
+  bool member[UCHAR_MAX + 1];
+  bool (*kernel)(const struct strlib_byte_set_t *set, const char *chars,
+                 size_t length, size_t *positions, size_t *num_positions,
+                 size_t positions_size);
+} strlib_byte_set_t;
+
+// Number of positions a multi-pattern replacement scans ahead at a time.
+#define STRLIB_CANDIDATE_BATCH 64
+
+// Indices at which a multi-pattern replacement may match, found a batch at
+// a time by scanning for the first chars of the needles in `starts`. The
+// chars before `scanned` have been scanned.
+typedef struct {
+  const strlib_byte_set_t *starts;
+  size_t positions[STRLIB_CANDIDATE_BATCH];
+  size_t num_positions;
+  size_t next;
+  size_t scanned;
+} strlib_candidates_t;
+
+// Number of items growable arrays of slices and edits start out with room
+// for.
+#define STRLIB_ITEMS_MIN_CAPACITY 16
+
+// An edit collected by an edit batch. It replaces the chars from `start`
+// to `end` (inclusive) with the `length` chars at `offset` in the batch's
+// chars, or inserts them at `start` if `insert` is set. `sequence` orders
+// edits at the same position by the time they were added.
+typedef struct {
+  size_t start;
+  size_t end;
+  size_t offset;
+  size_t length;
+  size_t sequence;
+  bool insert;
+  bool reversed;
+} strlib_edit_t;
+
+// Internal representation of the strlib_edits_t type. The chars of every
+// edit are copied to `chars`, so that callers need not keep them.
+struct strlib_edits_t {
+  strlib_edit_t *edits;
+  size_t num_edits;
+  size_t edits_capacity;
+  char *chars;
+  size_t num_chars;
+  size_t chars_capacity;
+};
+
+// Number of shards of an interning table, each locked on its own so that
+// threads interning different strings rarely wait on each other.
+#define STRLIB_INTERN_SHARD_BITS 4
+#define STRLIB_INTERN_SHARDS ((size_t)1 << STRLIB_INTERN_SHARD_BITS)
+
+// Size of the arena blocks interned strings are allocated from.
+#define STRLIB_INTERN_BLOCK_SIZE 65536
+
+// A slot of an interning table, empty while `s` is NULL.
+typedef struct {
+  uint64_t hash;
+  strlib_str_t *s;
+} strlib_intern_slot_t;
+
+// Part of an interning table holding the strings whose hashes share their
+// top bits. Slots are probed linearly from the low bits of the hash, and the
+// strings are allocated from `arena` until the table is freed.
+typedef struct {
+  pthread_rwlock_t lock;
+  strlib_intern_slot_t *slots;
+  size_t capacity;
+  size_t count;
+  strlib_arena_t *arena;
+} strlib_intern_shard_t;
+
+// Internal representation of the strlib_intern_t type.
+struct strlib_intern_t {
+  strlib_intern_shard_t shards[STRLIB_INTERN_SHARDS];
+};
+
+// Number of strings below which strlib_sort compares them one by one
+// rather than distributing them by their next char.
+#define STRLIB_SORT_INSERTION 32
+
+// A string being sorted by strlib_sort. `key` caches its 8 chars from the
+// last multiple of 8 at or below the char being sorted on, most significant
+// first and zero padded, so that most passes never touch `chars`.
+typedef struct {
+  uint64_t key;
+  const char *chars;
+  size_t length;
+  strlib_str_t *s;
+} strlib_sort_entry_t;
+
+// Alignment of every block handed out by the built-in allocators.
+#define STRLIB_ALIGNMENT _Alignof(max_align_t)
+
+// Capacity below which geometric growth doubles instead of growing by half.
+#define STRLIB_GROWTH_DOUBLING_LIMIT 4096
+
+// Granularity used by page-rounded growth.
+#define STRLIB_PAGE_SIZE 4096
+
+#ifdef STRLIB_INSTRUMENT
+// Every public operation, in the order reported by strlib_get_stats.
+#define STRLIB_OPERATIONS(X)  \
+  X(init)                     \
+  X(init_with_allocator)      \
+  X(init_with_representation) \
+  X(share)                    \
+  X(init_from_file)           \
+  X(map)                      \
+  X(find_char)                \
+  X(find_any_char)            \
+  X(find_any_char_n)          \
+  X(find_substr)              \
+  X(find_substr_n)            \
+  X(find_substr_view)         \
+  X(find_all)                 \
+  X(find_all_any_char)        \
+  X(find_all_any_char_n)      \
+  X(slices_free)              \
+  X(finder_init)              \
+  X(find_next)                \
+  X(finder_seek)              \
+  X(finder_free)              \
+  X(insert_char)              \
+  X(insert_chars)             \
+  X(insert_view)              \
+  X(get)                      \
+  X(get_char)                 \
+  X(get_slice)                \
+  X(get_view)                 \
+  X(get_slice_view)           \
+  X(compare_view)             \
+  X(compare)                  \
+  X(equals)                   \
+  X(equals_view)              \
+  X(starts_with)              \
+  X(ends_with)                \
+  X(sort)                     \
+  X(get_length)               \
+  X(get_capacity)             \
+  X(get_growth_policy)        \
+  X(set_growth_policy)        \
+  X(reserve)                  \
+  X(shrink_to_fit)            \
+  X(replace_char)             \
+  X(replace_slice)            \
+  X(replace_slice_n)          \
+  X(replace_slice_view)       \
+  X(replace_substr)           \
+  X(replace_substr_n)         \
+  X(replace_substr_max)       \
+  X(replace_substr_max_n)     \
+  X(replace_many)             \
+  X(remove_char)              \
+  X(remove_slice)             \
+  X(remove_substr)            \
+  X(remove_substr_n)          \
+  X(remove_slices)            \
+  X(remove_any_char)          \
+  X(remove_any_char_n)        \
+  X(edits_init)               \
+  X(edits_insert)             \
+  X(edits_remove)             \
+  X(edits_replace)            \
+  X(apply_edits)              \
+  X(edits_reset)              \
+  X(edits_free)               \
+  X(set)                      \
+  X(set_n)                    \
+  X(clear)                    \
+  X(assign_from)              \
+  X(append)                   \
+  X(append_str)               \
+  X(concat)                   \
+  X(concat_cstrs)             \
+  X(join)                     \
+  X(free)                     \
+  X(stream_init)              \
+  X(stream_feed)              \
+  X(stream_reset)             \
+  X(stream_free)              \
+  X(matcher_init)             \
+  X(matcher_find)             \
+  X(matcher_find_view)        \
+  X(matcher_free)             \
+  X(hash)                     \
+  X(hash_view)                \
+  X(intern_init)              \
+  X(intern)                   \
+  X(intern_str)               \
+  X(intern_free)              \
+  X(arena_init)               \
+  X(arena_get_allocator)      \
+  X(arena_reset)              \
+  X(arena_free)               \
+  X(pool_init)                \
+  X(pool_get_allocator)       \
+  X(pool_reset)               \
+  X(pool_free)
+
+// Identifiers of the public operations.
+enum {
+#define STRLIB_OPERATION_ID(name) STRLIB_OP_##name,
+  STRLIB_OPERATIONS(STRLIB_OPERATION_ID)
+#undef STRLIB_OPERATION_ID
+  STRLIB_NUM_OPERATIONS
 };
 
+// Counters updated by instrumented builds. They are only ever added to, so
+// relaxed atomics are enough for them to be updated from any thread.
+typedef struct {
+  atomic_ullong allocations;
+  atomic_ullong reallocations;
+  atomic_ullong releases;
+  atomic_ullong bytes_copied;
+  atomic_ullong bytes_moved;
+  atomic_ullong calls[STRLIB_NUM_OPERATIONS];
+  atomic_ullong ns[STRLIB_NUM_OPERATIONS];
+} strlib_counters_t;
+
+// Start of a call to a public operation, closed when it goes out of scope.
+typedef struct {
+  size_t operation;
+  unsigned long long start;
+} strlib_probe_t;
+
+#define STRLIB_COUNT(counter, n) \
+  (void)atomic_fetch_add_explicit(&counters.counter, (n), memory_order_relaxed)
+#define STRLIB_PROBE(name)                                  \
+  strlib_probe_t probe __attribute__((cleanup(probe_end))) = \
+      probe_begin(STRLIB_OP_##name)
+#else
+#define STRLIB_COUNT(counter, n) (void)0
+#define STRLIB_PROBE(name) (void)0
+#endif
+
+// Lock of a shared strlib string held for a public operation, released when
+// it goes out of scope. The guards a thread holds are linked through `prev`,
+// so that operations calling others on the same string lock it only once.
+typedef struct strlib_guard_t {
+  const strlib_str_t *s;
+  struct strlib_guard_t *prev;
+} strlib_guard_t;
+
+#define STRLIB_LOCK(s, exclusive)                                      \
+  strlib_guard_t guard __attribute__((cleanup(guard_unlock))) = {0}; \
+  if ((s)->lock != NULL) guard_lock(&guard, (s), (exclusive))
+#define STRLIB_MODIFY(s) \
+  STRLIB_LOCK(s, true);  \
+  forget_hash(s)
+#define STRLIB_LOCK_PAIR(a, a_exclusive, b, b_exclusive)                   \
+  strlib_guard_t guard_first __attribute__((cleanup(guard_unlock))) = {0};  \
+  strlib_guard_t guard_second __attribute__((cleanup(guard_unlock))) = {0}; \
+  guard_lock_pair(&guard_first, &guard_second, (a), (a_exclusive), (b),     \
+                  (b_exclusive))
+
 /*******************************************************************************/
 
 /*
 ** Helper functions which are for internal use by strlib only.
 */
 
+static void *libc_alloc(void *ctx, size_t size) {
+  (void)ctx;
+  return malloc(size);
+}
+
+static void *libc_resize(void *ctx, void *ptr, size_t old_size,
+                         size_t new_size) {
+  (void)ctx;
+  (void)old_size;
+  return realloc(ptr, new_size);
+}
+
+static void libc_release(void *ctx, void *ptr, size_t size) {
+  (void)ctx;
+  (void)size;
+  free(ptr);
+}
+
+// Allocator used by strlib_init, backed by the c standard library.
+static const strlib_allocator_t libc_allocator = {
+    .alloc = libc_alloc,
+    .resize = libc_resize,
+    .release = libc_release,
+    .ctx = NULL,
+};
+
+#ifdef STRLIB_INSTRUMENT
+static strlib_counters_t counters;
+
+static unsigned long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((unsigned long long)ts.tv_sec * 1000000000ull) +
+         (unsigned long long)ts.tv_nsec;
+}
+
+static strlib_probe_t probe_begin(const size_t operation) {
+  STRLIB_COUNT(calls[operation], 1);
+  return (strlib_probe_t){
+      .operation = operation,
+      .start = now_ns(),
+  };
+}
+
+static void probe_end(const strlib_probe_t *probe) {
+  STRLIB_COUNT(ns[probe->operation], now_ns() - probe->start);
+}
+#endif
+
+// Innermost guard held by the current thread.
+static __thread strlib_guard_t *held_guards;
+
+static void guard_lock(strlib_guard_t *guard, const strlib_str_t *s,
+                       const bool exclusive) {
+  // nothing to lock unless the string is shared and not held already
+  if (s->lock == NULL) return;
+  for (const strlib_guard_t *held = held_guards; held != NULL;
+       held = held->prev) {
+    if (held->s == s) return;
+  }
+
+  // reading a rope compacts it, so ropes are always locked exclusively
+  int rc = (exclusive || s->rope != NULL) ? pthread_rwlock_wrlock(s->lock)
+                                          : pthread_rwlock_rdlock(s->lock);
+  assert(rc == 0);
+  (void)rc;
+  guard->s = s;
+  guard->prev = held_guards;
+  held_guards = guard;
+}
+
+static void guard_lock_pair(strlib_guard_t *first, strlib_guard_t *second,
+                            const strlib_str_t *a, const bool a_exclusive,
+                            const strlib_str_t *b, const bool b_exclusive) {
+  // two strings are locked in address order, so that threads locking the
+  // same pair never wait on each other
+  if (a == b) {
+    guard_lock(first, a, a_exclusive || b_exclusive);
+  } else if ((uintptr_t)a < (uintptr_t)b) {
+    guard_lock(first, a, a_exclusive);
+    guard_lock(second, b, b_exclusive);
+  } else {
+    guard_lock(first, b, b_exclusive);
+    guard_lock(second, a, a_exclusive);
+  }
+}
+
+static void guard_unlock(strlib_guard_t *guard) {
+  if (guard->s == NULL) return;
+  held_guards = guard->prev;
+  (void)pthread_rwlock_unlock(guard->s->lock);
+}
+
+static void *allocate(const strlib_allocator_t *allocator, const size_t size) {
+  STRLIB_COUNT(allocations, 1);
+  return allocator->alloc(allocator->ctx, size);
+}
+
+static void *reallocate(const strlib_allocator_t *allocator, void *ptr,
+                        const size_t old_size, const size_t new_size) {
+  STRLIB_COUNT(reallocations, 1);
+  return allocator->resize(allocator->ctx, ptr, old_size, new_size);
+}
+
+static void deallocate(const strlib_allocator_t *allocator, void *ptr,
+                       const size_t size) {
+  STRLIB_COUNT(releases, 1);
+  allocator->release(allocator->ctx, ptr, size);
+}
+
+static void copy_bytes(void *dst, const void *src, const size_t n) {
+  STRLIB_COUNT(bytes_copied, n);
+  memcpy(dst, src, n);
+}
+
+static void move_bytes(void *dst, const void *src, const size_t n) {
+  STRLIB_COUNT(bytes_moved, n);
+  memmove(dst, src, n);
+}
+
+static size_t align_up(const size_t size) {
+  // zero signals overflow, which no allocation request can satisfy
+  if (size > SIZE_MAX - (STRLIB_ALIGNMENT - 1)) {
+    return 0;
+  }
+  return (size + (STRLIB_ALIGNMENT - 1)) & ~(STRLIB_ALIGNMENT - 1);
+}
+
+static char *arena_block_data(strlib_arena_block_t *block) {
+  return (char *)block + align_up(sizeof(strlib_arena_block_t));
+}
+
+static strlib_arena_block_t *arena_add_block(strlib_arena_t *arena,
+                                             const size_t size) {
+  size_t header = align_up(sizeof(strlib_arena_block_t));
+  size_t block_size = (size > arena->block_size) ? size : arena->block_size;
+  if (block_size > SIZE_MAX - header) {
+    return NULL;
+  }
+
+  strlib_arena_block_t *block = malloc(header + block_size);
+  if (block == NULL) {
+    return NULL;
+  }
+
+  // append so that blocks are bumped in allocation order after a reset
+  block->next = NULL;
+  block->size = block_size;
+  block->used = 0;
+  if (arena->tail != NULL) {
+    arena->tail->next = block;
+  } else {
+    arena->blocks = block;
+  }
+  arena->tail = block;
+
+  return block;
+}
+
+static void *arena_alloc(void *ctx, size_t size) {
+  strlib_arena_t *arena = ctx;
+  size_t aligned = align_up(size);
+  if (aligned == 0 && size != 0) {
+    return NULL;
+  }
+
+  // skip blocks which are too full, then fall back to a fresh block
+  strlib_arena_block_t *block = arena->current;
+  while (block != NULL && block->size - block->used < aligned) {
+    block = block->next;
+  }
+  if (block == NULL) {
+    block = arena_add_block(arena, aligned);
+    if (block == NULL) {
+      return NULL;
+    }
+  }
+
+  arena->current = block;
+  arena->last = arena_block_data(block) + block->used;
+  block->used += aligned;
+
+  return arena->last;
+}
+
+static void *arena_resize(void *ctx, void *ptr, size_t old_size,
+                          size_t new_size) {
+  strlib_arena_t *arena = ctx;
+
+  // the most recent allocation can grow or shrink in place
+  if (ptr != NULL && ptr == arena->last) {
+    size_t offset = (size_t)(arena->last - arena_block_data(arena->current));
+    size_t aligned = align_up(new_size);
+    if (aligned != 0 && aligned <= arena->current->size - offset) {
+      arena->current->used = offset + aligned;
+      return ptr;
+    }
+  }
+
+  // older allocations can only shrink in place
+  if (new_size <= old_size) {
+    return ptr;
+  }
+
+  void *moved = arena_alloc(ctx, new_size);
+  if (moved != NULL && ptr != NULL) {
+    memcpy(moved, ptr, old_size);
+  }
+  return moved;
+}
+
+static void arena_release(void *ctx, void *ptr, size_t size) {
+  strlib_arena_t *arena = ctx;
+  (void)size;
+
+  // only the most recent allocation is given back before a reset
+  if (ptr != NULL && ptr == arena->last) {
+    arena->current->used =
+        (size_t)(arena->last - arena_block_data(arena->current));
+    arena->last = NULL;
+  }
+}
+
+static char *pool_chunk_data(strlib_pool_chunk_t *chunk) {
+  return (char *)chunk + align_up(sizeof(strlib_pool_chunk_t));
+}
+
+static void pool_push_chunk(strlib_pool_t *pool, strlib_pool_chunk_t *chunk) {
+  char *objects = pool_chunk_data(chunk);
+
+  // thread every object of the chunk onto the free list
+  for (size_t i = 0; i < pool->objects_per_chunk; i++) {
+    void **object = (void *)(objects + (i * pool->object_size));
+    *object = pool->free_list;
+    pool->free_list = object;
+  }
+}
+
+static void *pool_alloc(void *ctx, size_t size) {
+  strlib_pool_t *pool = ctx;
+
+  // error if the object cannot hold the request
+  if (size > pool->object_size) {
+    return NULL;
+  }
+
+  // grab another chunk when the free list runs dry
+  if (pool->free_list == NULL) {
+    size_t header = align_up(sizeof(strlib_pool_chunk_t));
+    strlib_pool_chunk_t *chunk =
+        malloc(header + (pool->objects_per_chunk * pool->object_size));
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+    pool_push_chunk(pool, chunk);
+  }
+
+  void **object = pool->free_list;
+  pool->free_list = *object;
+  return object;
+}
+
+static void *pool_resize(void *ctx, void *ptr, size_t old_size,
+                         size_t new_size) {
+  strlib_pool_t *pool = ctx;
+  (void)old_size;
+
+  // objects have a fixed size, so they either fit or cannot grow
+  if (ptr == NULL) {
+    return pool_alloc(ctx, new_size);
+  }
+  return (new_size <= pool->object_size) ? ptr : NULL;
+}
+
+static void pool_release(void *ctx, void *ptr, size_t size) {
+  strlib_pool_t *pool = ctx;
+  (void)size;
+
+  if (ptr != NULL) {
+    void **object = ptr;
+    *object = pool->free_list;
+    pool->free_list = object;
+  }
+}
+
+static size_t geometric_step(const size_t capacity) {
+  // double small buffers, grow larger ones by half to bound wasted space
+  size_t step = (capacity < STRLIB_GROWTH_DOUBLING_LIMIT) ? capacity
+                                                          : capacity / 2;
+  return (step == 0) ? 1 : step;
+}
+
+static size_t grow_geometric(const size_t capacity, const size_t limit) {
+  size_t step = geometric_step(capacity);
+  if (step > limit) step = limit;
+
+  return (capacity > SIZE_MAX - step) ? SIZE_MAX : capacity + step;
+}
+
+static size_t next_capacity(const strlib_growth_policy_t policy,
+                            const size_t capacity, const size_t required) {
+  size_t next = capacity;
+
+  if (policy.strategy == STRLIB_GROWTH_EXACT) {
+    return required;
+  }
+
+  if (policy.strategy == STRLIB_GROWTH_PAGE) {
+    size_t pages = (required / STRLIB_PAGE_SIZE) +
+                   ((required % STRLIB_PAGE_SIZE) != 0 ? 1 : 0);
+    return (pages > SIZE_MAX / STRLIB_PAGE_SIZE) ? required
+                                                 : pages * STRLIB_PAGE_SIZE;
+  }
+
+  // geometric and capped growth step until the requirement is met
+  size_t limit =
+      (policy.strategy == STRLIB_GROWTH_CAPPED) ? policy.limit : SIZE_MAX;
+  while (next < required) {
+    // once the step reaches the cap, the remaining steps are counted at once
+    if (geometric_step(next) >= limit) {
+      size_t steps = ((required - next) / limit) +
+                     (((required - next) % limit) != 0 ? 1 : 0);
+      return (steps > (SIZE_MAX - next) / limit) ? SIZE_MAX
+                                                 : next + (steps * limit);
+    }
+    next = grow_geometric(next, limit);
+  }
+
+  return next;
+}
+
+static bool is_small(const strlib_str_t *s) { return s->chars == s->small; }
+
+static bool is_mapped(const strlib_str_t *s) { return s->map_size != 0; }
+
+static void release_chars(strlib_str_t *s) {
+  // mapped contents are unmapped, heap ones released and inline ones kept
+  if (is_mapped(s)) {
+    (void)munmap(s->chars, s->map_size);
+    s->map_size = 0;
+  } else if (!is_small(s)) {
+    deallocate(s->allocator, s->chars, s->capacity);
+  }
+}
+
+static strlib_result_t set_capacity(strlib_str_t *s, const size_t capacity) {
+  // move heap or mapped contents back inline once they fit again
+  if (capacity <= STRLIB_SMALL_CAPACITY) {
+    if (!is_small(s)) {
+      copy_bytes(s->small, s->chars, s->length + 1);
+      release_chars(s);
+      s->chars = s->small;
+    }
+    s->capacity = STRLIB_SMALL_CAPACITY;
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  // keep the old buffer intact if reallocation fails
+  bool owned = !is_small(s) && !is_mapped(s);
+  char *chars =
+      owned
+          ? (char *)reallocate(s->allocator, s->chars, s->capacity, capacity)
+          : (char *)allocate(s->allocator, capacity);
+
+  // error if space for char array isn't allocated
+  if (chars == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  // inline and mapped contents are copied out with their null terminator
+  if (!owned) {
+    copy_bytes(chars, s->chars, s->length + 1);
+    release_chars(s);
+  }
+
+  s->chars = chars;
+  s->capacity = capacity;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t ensure_capacity(strlib_str_t *s, const size_t required) {
+  // nothing to do if the chars already fit
+  if (required <= s->capacity) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  // fall back to the exact requirement when the policy overshoots what the
+  // allocator can provide
+  size_t capacity = next_capacity(s->growth, s->capacity, required);
+  strlib_result_t res = set_capacity(s, capacity);
+  if (res.code == STRLIB_E_NO_MEMORY && capacity > required) {
+    res = set_capacity(s, required);
+  }
+
+  return res;
+}
+
+static strlib_result_t own_chars(strlib_str_t *s) {
+  // mapped contents are copied out before they are first modified
+  if (!is_mapped(s)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+  return set_capacity(s, s->length + 1);
+}
+
 static strlib_result_t resize_chars(strlib_str_t *s, size_t additional_cs) {
-  // allocate capacity for additional chars if needed
-  if ((s->length + additional_cs) >= s->capacity) {
-    s->capacity += additional_cs;
-    s->chars = (char *)realloc(s->chars, s->capacity);
+  // error if the required capacity cannot be represented
+  if (additional_cs > SIZE_MAX - s->length - 1) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  // allocate capacity for additional chars and the null terminator if needed
+  return ensure_capacity(s, s->length + additional_cs + 1);
+}
+
+static void reverse_copy_scalar(char *dst, const char *src, const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    dst[i] = src[n - 1 - i];
+  }
+}
+
+#ifdef STRLIB_X86_SIMD
+static bool cpu_has_avx2(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+static void reverse_copy_sse2(char *dst, const char *src, const size_t n) {
+  size_t i = 0;
+
+  // reverse 16 chars at once: swap bytes in words, words in halves, halves
+  for (; i + 16 <= n; i += 16) {
+    __m128i block = _mm_loadu_si128((const void *)(src + n - 16 - i));
+    block = _mm_or_si128(_mm_slli_epi16(block, 8), _mm_srli_epi16(block, 8));
+    block = _mm_shufflelo_epi16(block, 0x1B);
+    block = _mm_shufflehi_epi16(block, 0x1B);
+    block = _mm_shuffle_epi32(block, 0x4E);
+    _mm_storeu_si128((void *)(dst + i), block);
+  }
+
+  reverse_copy_scalar(dst + i, src, n - i);
+}
+
+__attribute__((target("avx2"))) static void reverse_copy_avx2(
+    char *dst, const char *src, const size_t n) {
+  const __m256i lanes = _mm256_setr_epi8(
+      15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12,
+      11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  size_t i = 0;
+
+  // reverse 32 chars at once: bytes within each lane, then the lanes
+  for (; i + 32 <= n; i += 32) {
+    __m256i block = _mm256_loadu_si256((const void *)(src + n - 32 - i));
+    block = _mm256_shuffle_epi8(block, lanes);
+    block = _mm256_permute2x128_si256(block, block, 0x01);
+    _mm256_storeu_si256((void *)(dst + i), block);
+  }
+
+  reverse_copy_sse2(dst + i, src, n - i);
+}
+#endif
+
+static void reverse_copy(char *dst, const char *src, const size_t n) {
+  // `dst` receives the n chars of `src` last to first, they may not overlap
+  STRLIB_COUNT(bytes_copied, n);
+#ifdef STRLIB_X86_SIMD
+  if (n >= 32 && cpu_has_avx2()) {
+    reverse_copy_avx2(dst, src, n);
+    return;
+  }
+  reverse_copy_sse2(dst, src, n);
+#else
+  reverse_copy_scalar(dst, src, n);
+#endif
+}
+
+static bool is_rope(const strlib_str_t *s) {
+  return s->rope != NULL && s->rope->active;
+}
+
+static size_t rope_size(const strlib_rope_node_t *node) {
+  return (node == NULL) ? 0 : node->size;
+}
+
+static void rope_update(strlib_rope_node_t *node) {
+  node->size = rope_size(node->left) + node->length + rope_size(node->right);
+}
+
+static uint32_t rope_priority(strlib_rope_t *rope) {
+  // xorshift32 is random enough to keep the treap balanced
+  uint32_t x = rope->seed;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rope->seed = x;
+  return x;
+}
+
+static char *rope_block_data(strlib_rope_block_t *block) {
+  return (char *)block + sizeof(strlib_rope_block_t);
+}
+
+static bool rope_reserve_nodes(strlib_rope_t *rope,
+                               const strlib_allocator_t *allocator,
+                               const size_t num_nodes) {
+  // nodes are allocated up front so that edits never fail half way through
+  while (rope->num_free_nodes < num_nodes) {
+    strlib_rope_node_t *node = (strlib_rope_node_t *)allocate(
+        allocator, sizeof(strlib_rope_node_t));
+    if (node == NULL) {
+      return false;
+    }
+    node->left = rope->free_nodes;
+    rope->free_nodes = node;
+    rope->num_free_nodes++;
+  }
+
+  return true;
+}
+
+static strlib_rope_node_t *rope_new_node(strlib_rope_t *rope,
+                                         const char *chars,
+                                         const size_t length,
+                                         const uint32_t priority) {
+  // take a node reserved beforehand
+  strlib_rope_node_t *node = rope->free_nodes;
+  rope->free_nodes = node->left;
+  rope->num_free_nodes--;
+
+  *node = (strlib_rope_node_t){
+      .left = NULL,
+      .right = NULL,
+      .chars = chars,
+      .length = length,
+      .size = length,
+      .priority = priority,
+  };
+  return node;
+}
+
+static void rope_drop_nodes(strlib_rope_t *rope, strlib_rope_node_t *node) {
+  // hand a whole subtree back to the free nodes
+  while (node != NULL) {
+    rope_drop_nodes(rope, node->right);
+    strlib_rope_node_t *left = node->left;
+    node->left = rope->free_nodes;
+    rope->free_nodes = node;
+    rope->num_free_nodes++;
+    node = left;
+  }
+}
+
+static void rope_split(strlib_rope_t *rope, strlib_rope_node_t *node,
+                       const size_t position, strlib_rope_node_t **left,
+                       strlib_rope_node_t **right) {
+  if (node == NULL) {
+    *left = NULL;
+    *right = NULL;
+    return;
+  }
+
+  size_t before = rope_size(node->left);
+  if (position <= before) {
+    rope_split(rope, node->left, position, left, &node->left);
+    *right = node;
+  } else if (position >= before + node->length) {
+    rope_split(rope, node->right, position - before - node->length,
+               &node->right, right);
+    *left = node;
+  } else {
+    // a piece cut in two keeps its priority in both halves, which preserves
+    // the heap order; this needs one reserved node
+    size_t cut = position - before;
+    strlib_rope_node_t *tail = rope_new_node(
+        rope, node->chars + cut, node->length - cut, node->priority);
+    tail->right = node->right;
+    rope_update(tail);
+    node->length = cut;
+    node->right = NULL;
+    *left = node;
+    *right = tail;
+  }
+  rope_update(node);
+}
+
+static strlib_rope_node_t *rope_merge(strlib_rope_node_t *left,
+                                      strlib_rope_node_t *right) {
+  if (left == NULL) return right;
+  if (right == NULL) return left;
+
+  if (left->priority >= right->priority) {
+    left->right = rope_merge(left->right, right);
+    rope_update(left);
+    return left;
+  }
+  right->left = rope_merge(left, right->left);
+  rope_update(right);
+  return right;
+}
+
+static void rope_copy(const strlib_rope_node_t *node, size_t position,
+                      size_t n, char **out, const bool reversed) {
+  // copy the pieces overlapping the range in order; a reversed copy writes
+  // backwards from `out`
+  while (node != NULL && n > 0) {
+    size_t before = rope_size(node->left);
+    if (position < before) {
+      size_t take = (n < before - position) ? n : before - position;
+      rope_copy(node->left, position, take, out, reversed);
+      n -= take;
+      position = before;
+    }
+    if (n > 0 && position < before + node->length) {
+      size_t offset = position - before;
+      size_t take = (n < node->length - offset) ? n : node->length - offset;
+      if (reversed) {
+        *out -= take;
+        reverse_copy(*out, node->chars + offset, take);
+      } else {
+        copy_bytes(*out, node->chars + offset, take);
+        *out += take;
+      }
+      n -= take;
+      position += take;
+    }
+    if (n == 0) {
+      return;
+    }
+    position -= before + node->length;
+    node = node->right;
+  }
+}
+
+static bool rope_grow_piece(strlib_rope_node_t *node, const size_t position,
+                            const char *tail, const size_t n) {
+  // find the piece ending at position and grow it by n chars if they will
+  // be appended right behind its own
+  if (node == NULL) {
+    return false;
+  }
+
+  bool grown = false;
+  size_t before = rope_size(node->left);
+  if (position <= before) {
+    grown = rope_grow_piece(node->left, position, tail, n);
+  } else if (position == before + node->length) {
+    grown = (node->chars + node->length == tail);
+    node->length += grown ? n : 0;
+  } else if (position > before + node->length) {
+    grown = rope_grow_piece(node->right, position - before - node->length,
+                            tail, n);
+  }
+  node->size += grown ? n : 0;
+
+  return grown;
+}
+
+static const char *rope_append(strlib_rope_t *rope,
+                               const strlib_allocator_t *allocator,
+                               const char *cs, const size_t n,
+                               const bool reversed) {
+  strlib_rope_block_t *block = rope->blocks;
+
+  // start a new block twice the size of the last one when out of room
+  if (block == NULL || block->size - block->used < n) {
+    size_t size = STRLIB_ROPE_MIN_BLOCK_SIZE;
+    if (block != NULL) {
+      size = (block->size < STRLIB_ROPE_MAX_BLOCK_SIZE / 2)
+                 ? block->size * 2
+                 : STRLIB_ROPE_MAX_BLOCK_SIZE;
+    }
+    if (size < n) size = n;
+    if (size > SIZE_MAX - sizeof(strlib_rope_block_t)) {
+      return NULL;
+    }
+
+    block = (strlib_rope_block_t *)allocate(
+        allocator, sizeof(strlib_rope_block_t) + size);
+    if (block == NULL) {
+      return NULL;
+    }
+    block->next = rope->blocks;
+    block->size = size;
+    block->used = 0;
+    rope->blocks = block;
+    rope->bytes += size;
+  }
+
+  char *chars = rope_block_data(block) + block->used;
+  if (reversed) {
+    reverse_copy(chars, cs, n);
+  } else {
+    copy_bytes(chars, cs, n);
+  }
+  block->used += n;
+
+  return chars;
+}
+
+static void rope_clear(strlib_rope_t *rope,
+                       const strlib_allocator_t *allocator) {
+  // drop every piece along with the buffers they borrow from
+  rope_drop_nodes(rope, rope->root);
+  rope->root = NULL;
+  while (rope->blocks != NULL) {
+    strlib_rope_block_t *next = rope->blocks->next;
+    deallocate(allocator, rope->blocks,
+               sizeof(strlib_rope_block_t) + rope->blocks->size);
+    rope->blocks = next;
+  }
+  if (rope->base != NULL) {
+    deallocate(allocator, rope->base, rope->base_size);
+    rope->base = NULL;
+    rope->base_size = 0;
+  }
+  rope->bytes = 0;
+}
+
+static strlib_result_t rope_activate(strlib_str_t *s) {
+  strlib_rope_t *rope = s->rope;
+  if (rope->active) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  if (!rope_reserve_nodes(rope, s->allocator, 1)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  strlib_result_t res = own_chars(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // a heap buffer is taken over as the base, inline contents are copied out
+  const char *chars = s->chars;
+  if (!is_small(s)) {
+    rope->base = s->chars;
+    rope->base_size = s->capacity;
+    rope->bytes += s->capacity;
+  } else if (s->length != 0) {
+    chars = rope_append(rope, s->allocator, s->chars, s->length, false);
+    if (chars == NULL) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+  }
+  if (s->length != 0) {
+    rope->root = rope_new_node(rope, chars, s->length, rope_priority(rope));
+  }
+
+  s->chars = s->small;
+  s->capacity = STRLIB_SMALL_CAPACITY;
+  s->small[0] = '\0';
+  rope->active = true;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t flatten(strlib_str_t *s) {
+  // nothing to do unless a rope holds the contents
+  if (!is_rope(s)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+  strlib_rope_t *rope = s->rope;
+  strlib_rope_node_t *root = rope->root;
+
+  // a single piece at the start of the base is handed back without copying
+  if (root != NULL && root->left == NULL && root->right == NULL &&
+      root->chars == rope->base) {
+    s->chars = rope->base;
+    s->capacity = rope->base_size;
+    s->chars[s->length] = '\0';
+    rope->base = NULL;
+    rope->base_size = 0;
+    rope_clear(rope, s->allocator);
+    rope->active = false;
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  // otherwise the pieces are gathered, inline if they fit
+  char *chars = s->small;
+  size_t capacity = STRLIB_SMALL_CAPACITY;
+  if (s->length >= STRLIB_SMALL_CAPACITY) {
+    capacity = s->length + 1;
+    chars = (char *)allocate(s->allocator, capacity);
+    if (chars == NULL) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+  }
+  char *out = chars;
+  rope_copy(root, 0, s->length, &out, false);
+  chars[s->length] = '\0';
+
+  rope_clear(rope, s->allocator);
+  rope->active = false;
+  s->chars = chars;
+  s->capacity = capacity;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t rope_compact(strlib_rope_t *rope,
+                                    const strlib_allocator_t *allocator,
+                                    const size_t length) {
+  // nothing to do if the contents already are a single piece
+  strlib_rope_node_t *root = rope->root;
+  if (root == NULL || (root->left == NULL && root->right == NULL)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  // gather the pieces into a new base, the old nodes cover the new piece
+  char *base = (char *)allocate(allocator, length + 1);
+  if (base == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  char *out = base;
+  rope_copy(root, 0, length, &out, false);
+  base[length] = '\0';
+
+  rope_clear(rope, allocator);
+  rope->base = base;
+  rope->base_size = length + 1;
+  rope->bytes = length + 1;
+  rope->root = rope_new_node(rope, base, length, rope_priority(rope));
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t borrow_chars(const strlib_str_t *s,
+                                    const char **chars) {
+  // a rope is compacted so that its contents can be borrowed as one array
+  *chars = s->chars;
+  if (is_rope(s)) {
+    strlib_result_t res = rope_compact(s->rope, s->allocator, s->length);
+    if (res.code != STRLIB_E_SUCCESS) {
+      return res;
+    }
+    if (s->rope->root != NULL) {
+      *chars = s->rope->root->chars;
+    }
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t rope_insert(strlib_str_t *s, const char *cs,
+                                   const size_t len_cs, const size_t position,
+                                   const bool reversed) {
+  strlib_result_t res = rope_activate(s);
+  if (res.code != STRLIB_E_SUCCESS || len_cs == 0) {
+    return res;
+  }
+  strlib_rope_t *rope = s->rope;
+
+  // chars appended right behind the piece ending at position just grow
+  // that piece, which keeps typing from adding a piece per char
+  strlib_rope_block_t *block = rope->blocks;
+  if (block != NULL && block->size - block->used >= len_cs &&
+      rope_grow_piece(rope->root, position,
+                      rope_block_data(block) + block->used, len_cs)) {
+    (void)rope_append(rope, s->allocator, cs, len_cs, reversed);
+    s->length += len_cs;
+    return res;
+  }
+
+  if (!rope_reserve_nodes(rope, s->allocator, 2)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  const char *chars = rope_append(rope, s->allocator, cs, len_cs, reversed);
+  if (chars == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  // split the pieces at position and put the new one in between
+  strlib_rope_node_t *left = NULL;
+  strlib_rope_node_t *right = NULL;
+  rope_split(rope, rope->root, position, &left, &right);
+  strlib_rope_node_t *node =
+      rope_new_node(rope, chars, len_cs, rope_priority(rope));
+  rope->root = rope_merge(rope_merge(left, node), right);
+  s->length += len_cs;
+
+  return res;
+}
+
+static strlib_result_t rope_remove(strlib_str_t *s, const size_t position,
+                                   const size_t x) {
+  strlib_result_t res = rope_activate(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  strlib_rope_t *rope = s->rope;
+
+  if (!rope_reserve_nodes(rope, s->allocator, 2)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  // cut out the pieces covering the removed chars
+  strlib_rope_node_t *left = NULL;
+  strlib_rope_node_t *middle = NULL;
+  strlib_rope_node_t *right = NULL;
+  rope_split(rope, rope->root, position, &left, &middle);
+  rope_split(rope, middle, x, &middle, &right);
+  rope_drop_nodes(rope, middle);
+  rope->root = rope_merge(left, right);
+  s->length -= x;
+
+  return res;
+}
+
+static void rope_read(const strlib_str_t *s, char *buf,
+                      const size_t position, const size_t n,
+                      const bool reversed) {
+  // only the null terminator at index length is not held by a piece
+  size_t stored = (position + n > s->length) ? s->length - position : n;
+  char *out = reversed ? buf + n : buf;
+  rope_copy(s->rope->root, position, stored, &out, reversed);
+  if (stored < n) {
+    buf[reversed ? 0 : stored] = '\0';
+  }
+}
+
+static void drop_mapping(strlib_str_t *s) {
+  // mapped contents about to be replaced are unmapped rather than copied
+  if (is_mapped(s)) {
+    release_chars(s);
+    s->chars = s->small;
+    s->capacity = STRLIB_SMALL_CAPACITY;
+    s->length = 0;
+    s->small[0] = '\0';
+  }
+}
+
+static strlib_result_t ensure_empty_capacity(strlib_str_t *s,
+                                             const size_t required) {
+  // an emptied heap buffer too small for what comes next is released and
+  // a new one allocated, as reallocating it could copy its dead bytes
+  if (required <= s->capacity || is_small(s) || is_mapped(s)) {
+    return ensure_capacity(s, required);
+  }
+  size_t capacity = next_capacity(s->growth, s->capacity, required);
+  release_chars(s);
+  s->chars = s->small;
+  s->capacity = STRLIB_SMALL_CAPACITY;
+  s->small[0] = '\0';
+
+  char *chars = (char *)allocate(s->allocator, capacity);
+  if (chars == NULL && capacity > required) {
+    capacity = required;
+    chars = (char *)allocate(s->allocator, capacity);
+  }
+  if (chars == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  chars[0] = '\0';
+  s->chars = chars;
+  s->capacity = capacity;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t set_chars(strlib_str_t *s, const char *chars,
+                                 const size_t length) {
+  // error if the null terminator cannot be added
+  if (length == SIZE_MAX) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  // the old contents are dropped before growing, so they are never copied,
+  // and a rope's pieces are dropped rather than gathered
+  if (is_rope(s)) {
+    rope_clear(s->rope, s->allocator);
+    s->rope->active = false;
+  }
+  drop_mapping(s);
+  s->length = 0;
+  s->chars[0] = '\0';
+  strlib_result_t res = ensure_empty_capacity(s, length + 1);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // only the new chars and their terminator are written
+  if (length != 0) {
+    copy_bytes(s->chars, chars, length);
+  }
+  s->chars[length] = '\0';
+  s->length = length;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t validate_insert_position(const strlib_str_t *s,
+                                                const size_t position) {
+  // error if inserting past length (can insert at end)
+  if (position > s->length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_INDEX,
+    };
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t shift_chars_right_by_x_from_position(strlib_str_t *s,
+                                                            size_t x,
+                                                            size_t position) {
+  // move chars to make room for insert, including the null terminator
+  move_bytes(s->chars + position + x, s->chars + position,
+             (s->length - position) + 1);
+
+  // update length for additional substr length
+  s->length += x;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t write_characters_to_position(strlib_str_t *s,
+                                                    const char *cs,
+                                                    const size_t strlen_cs,
+                                                    const size_t position,
+                                                    const bool reversed) {
+  // write cs into position
+  if (reversed) {
+    reverse_copy(s->chars + position, cs, strlen_cs);
+  } else {
+    copy_bytes(s->chars + position, cs, strlen_cs);
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static size_t search_scalar(const strlib_search_t *search, const char *chars,
+                            const size_t length, const size_t from) {
+  const char *needle = search->needle;
+  size_t len_needle = search->length;
+  size_t last = length - len_needle;
+
+  // look for the first char, then verify the rest of the candidate
+  for (size_t i = from; i <= last;) {
+    const char *head = memchr(chars + i, needle[0], (last - i) + 1);
+    if (head == NULL) {
+      break;
+    }
+    i = (size_t)(head - chars);
+    if (memcmp(head + 1, needle + 1, len_needle - 1) == 0) {
+      return i;
+    }
+    i++;
+  }
+
+  return STRLIB_NOT_FOUND;
+}
+
+#ifdef STRLIB_X86_SIMD
+static size_t search_sse2(const strlib_search_t *search, const char *chars,
+                          const size_t length, const size_t from) {
+  const char *needle = search->needle;
+  size_t len_needle = search->length;
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[len_needle - 1]);
+  size_t i = from;
+
+  // compare 16 candidates at once on their first and last chars
+  for (; i + len_needle + 15 <= length; i += 16) {
+    __m128i block_first = _mm_loadu_si128((const void *)(chars + i));
+    __m128i block_last =
+        _mm_loadu_si128((const void *)(chars + i + len_needle - 1));
+    unsigned mask = (unsigned)_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                      _mm_cmpeq_epi8(last, block_last)));
+
+    // verify the middle of every candidate, in order
+    while (mask != 0) {
+      size_t head = i + (size_t)__builtin_ctz(mask);
+      if (memcmp(chars + head + 1, needle + 1, len_needle - 2) == 0) {
+        return head;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  // finish the tail which cannot fill a whole vector
+  return (i + len_needle <= length) ? search_scalar(search, chars, length, i)
+                                    : STRLIB_NOT_FOUND;
+}
+
+__attribute__((target("avx2"))) static size_t search_avx2(
+    const strlib_search_t *search, const char *chars, const size_t length,
+    const size_t from) {
+  const char *needle = search->needle;
+  size_t len_needle = search->length;
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[len_needle - 1]);
+  size_t i = from;
+
+  // compare 32 candidates at once on their first and last chars
+  for (; i + len_needle + 31 <= length; i += 32) {
+    __m256i block_first = _mm256_loadu_si256((const void *)(chars + i));
+    __m256i block_last =
+        _mm256_loadu_si256((const void *)(chars + i + len_needle - 1));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                         _mm256_cmpeq_epi8(last, block_last)));
+
+    // verify the middle of every candidate, in order
+    while (mask != 0) {
+      size_t head = i + (size_t)__builtin_ctz(mask);
+      if (memcmp(chars + head + 1, needle + 1, len_needle - 2) == 0) {
+        return head;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  // finish the tail which cannot fill a whole vector
+  return (i + len_needle <= length) ? search_sse2(search, chars, length, i)
+                                    : STRLIB_NOT_FOUND;
+}
+#endif
+
+static bool scan_scalar(const strlib_byte_set_t *set, const char *chars,
+                        const size_t length, size_t *positions,
+                        size_t *num_positions, const size_t positions_size) {
+  const unsigned char *bytes = (const unsigned char *)chars;
+
+  for (size_t i = 0; i < length; i++) {
+    if (set->member[bytes[i]]) {
+      if (*num_positions >= positions_size) {
+        return false;
+      }
+      positions[(*num_positions)++] = i;
+    }
+  }
+
+  return true;
+}
+
+#ifdef STRLIB_X86_SIMD
+static bool store_positions(const size_t base, unsigned mask,
+                            size_t *positions, size_t *num_positions,
+                            const size_t positions_size) {
+  // store the position of every set bit, lowest first
+  while (mask != 0) {
+    if (*num_positions >= positions_size) {
+      return false;
+    }
+    positions[(*num_positions)++] = base + (size_t)__builtin_ctz(mask);
+    mask &= mask - 1;
+  }
+
+  return true;
+}
+
+static bool scan_sse2(const strlib_byte_set_t *set, const char *chars,
+                      const size_t length, size_t *positions,
+                      size_t *num_positions, const size_t positions_size) {
+  __m128i needles[STRLIB_BYTE_SET_SIMD_LIMIT];
+  for (size_t k = 0; k < set->num_bytes; k++) {
+    needles[k] = _mm_set1_epi8((char)set->bytes[k]);
+  }
+
+  // compare 16 chars against every byte of the set at once
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m128i block = _mm_loadu_si128((const void *)(chars + i));
+    __m128i hits = _mm_cmpeq_epi8(block, needles[0]);
+    for (size_t k = 1; k < set->num_bytes; k++) {
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[k]));
+    }
+    if (!store_positions(i, (unsigned)_mm_movemask_epi8(hits), positions,
+                         num_positions, positions_size)) {
+      return false;
+    }
+  }
+
+  // finish the tail which cannot fill a whole vector
+  size_t tail = *num_positions;
+  bool res = scan_scalar(set, chars + i, length - i, positions, num_positions,
+                         positions_size);
+  for (; tail < *num_positions; tail++) positions[tail] += i;
+  return res;
+}
+
+__attribute__((target("avx2"))) static bool scan_avx2(
+    const strlib_byte_set_t *set, const char *chars, const size_t length,
+    size_t *positions, size_t *num_positions, const size_t positions_size) {
+  __m256i needles[STRLIB_BYTE_SET_SIMD_LIMIT];
+  for (size_t k = 0; k < set->num_bytes; k++) {
+    needles[k] = _mm256_set1_epi8((char)set->bytes[k]);
+  }
+
+  // compare 32 chars against every byte of the set at once
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i block = _mm256_loadu_si256((const void *)(chars + i));
+    __m256i hits = _mm256_cmpeq_epi8(block, needles[0]);
+    for (size_t k = 1; k < set->num_bytes; k++) {
+      hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[k]));
+    }
+    if (!store_positions(i, (unsigned)_mm256_movemask_epi8(hits), positions,
+                         num_positions, positions_size)) {
+      return false;
+    }
+  }
+
+  // finish the tail which cannot fill a whole vector
+  size_t tail = *num_positions;
+  bool res = scan_scalar(set, chars + i, length - i, positions, num_positions,
+                         positions_size);
+  for (; tail < *num_positions; tail++) positions[tail] += i;
+  return res;
+}
+#endif
+
+static size_t maximal_suffix(const unsigned char *needle,
+                             const size_t len_needle, const bool reversed,
+                             size_t *period) {
+  // `suffix` starts out as -1 and relies on well defined unsigned wrapping
+  size_t suffix = SIZE_MAX;
+  size_t j = 0;
+  size_t k = 1;
+  size_t p = 1;
+
+  while (j + k < len_needle) {
+    unsigned char a = needle[j + k];
+    unsigned char b = needle[suffix + k];
+    if (reversed ? (a > b) : (a < b)) {
+      // the suffix continues, so its period grows
+      j += k;
+      k = 1;
+      p = j - suffix;
+    } else if (a == b) {
+      // the suffix continues within its current period
+      if (k != p) {
+        k++;
+      } else {
+        j += p;
+        k = 1;
+      }
+    } else {
+      // a larger suffix starts here
+      suffix = j++;
+      k = 1;
+      p = 1;
+    }
+  }
+
+  *period = p;
+  return suffix + 1;
+}
+
+static void two_way_init(strlib_search_t *search) {
+  const unsigned char *needle = (const unsigned char *)search->needle;
+  size_t len_needle = search->length;
+  size_t period = 0;
+  size_t period_reversed = 0;
+
+  // the critical factorization is the later of both maximal suffixes
+  size_t suffix = maximal_suffix(needle, len_needle, false, &period);
+  size_t suffix_reversed =
+      maximal_suffix(needle, len_needle, true, &period_reversed);
+  if (suffix_reversed > suffix) {
+    suffix = suffix_reversed;
+    period = period_reversed;
+  }
+
+  // without a true period, shift past the longer half of the factorization
+  search->critical = suffix;
+  search->periodic =
+      memcmp(search->needle, search->needle + period, suffix) == 0;
+  if (!search->periodic) {
+    period = (suffix > len_needle - suffix) ? suffix : len_needle - suffix;
+    period++;
+  }
+  search->period = period;
+}
+
+static size_t search_two_way(const strlib_search_t *search, const char *chars,
+                             const size_t length, const size_t from) {
+  const unsigned char *needle = (const unsigned char *)search->needle;
+  const unsigned char *hay = (const unsigned char *)chars;
+  size_t len_needle = search->length;
+  size_t critical = search->critical;
+  size_t memory = 0;
+
+  for (size_t j = from; j <= length - len_needle;) {
+    // match the right half, skipping what a periodic needle already matched
+    size_t i = (critical > memory) ? critical : memory;
+    while (i < len_needle && needle[i] == hay[i + j]) i++;
+    if (i < len_needle) {
+      j += i - critical + 1;
+      memory = 0;
+      continue;
+    }
+
+    // match the left half from right to left (again wrapping past zero)
+    size_t low = search->periodic ? memory : 0;
+    i = critical - 1;
+    while (i + 1 > low && needle[i] == hay[i + j]) i--;
+    if (i + 1 <= low) {
+      return j;
+    }
+
+    j += search->period;
+    memory = search->periodic ? len_needle - search->period : 0;
+  }
+
+  return STRLIB_NOT_FOUND;
+}
+
+static void search_init(strlib_search_t *search, const char *needle,
+                        const size_t len_needle) {
+  search->needle = needle;
+  search->length = len_needle;
+  search->kernel = search_scalar;
+
+  // long needles are matched in linear time
+  if (len_needle > STRLIB_TWO_WAY_THRESHOLD) {
+    two_way_init(search);
+    search->kernel = search_two_way;
+    return;
+  }
+
+  // short needles use the widest first/last char filter the cpu supports
+#ifdef STRLIB_X86_SIMD
+  if (len_needle >= 2) {
+    search->kernel = cpu_has_avx2() ? search_avx2 : search_sse2;
+  }
+#endif
+}
+
+static size_t search_next(const strlib_search_t *search, const char *chars,
+                          const size_t length, const size_t from) {
+  // an empty needle never matches
+  if (search->length == 0 || search->length > length ||
+      from > length - search->length) {
+    return STRLIB_NOT_FOUND;
+  }
+
+  return search->kernel(search, chars, length, from);
+}
+
+static void byte_set_init(strlib_byte_set_t *set, const unsigned char *bytes,
+                          const size_t num_bytes) {
+  *set = (strlib_byte_set_t){0};
+  set->kernel = scan_scalar;
+
+  // flag every byte, remembering the distinct ones for vector compares
+  for (size_t i = 0; i < num_bytes; i++) {
+    if (!set->member[bytes[i]]) {
+      set->member[bytes[i]] = true;
+      if (set->num_bytes < STRLIB_BYTE_SET_SIMD_LIMIT) {
+        set->bytes[set->num_bytes] = bytes[i];
+      }
+      set->num_bytes++;
+    }
+  }
+
+  // small sets use the widest compare the cpu supports
+#ifdef STRLIB_X86_SIMD
+  if (set->num_bytes > 0 && set->num_bytes <= STRLIB_BYTE_SET_SIMD_LIMIT) {
+    set->kernel = cpu_has_avx2() ? scan_avx2 : scan_sse2;
+  }
+#endif
+}
+
+static strlib_result_t find_byte_set(strlib_str_t *s, size_t *positions,
+                                     size_t *num_positions,
+                                     const size_t positions_size,
+                                     const unsigned char *bytes,
+                                     const size_t num_bytes) {
+  assert(s);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  strlib_byte_set_t set;
+  byte_set_init(&set, bytes, num_bytes);
+
+  // scan straight into the caller's positions
+  *num_positions = 0;
+  if (!set.kernel(&set, s->chars, s->length, positions, num_positions,
+                  positions_size)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_SIZE,
+    };
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t replace_substr(strlib_str_t *s,
+                                      const strlib_view_t substr,
+                                      const strlib_view_t cs,
+                                      const size_t max_replacements,
+                                      size_t *num_replaced) {
+  assert(s);
+  *num_replaced = 0;
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  strlib_search_t search;
+  search_init(&search, substr.chars, substr.length);
+
+  // count the non-overlapping matches to size the result once
+  size_t count = 0;
+  size_t head = search_next(&search, s->chars, s->length, 0);
+  while (head != STRLIB_NOT_FOUND && count < max_replacements) {
+    count++;
+    head = search_next(&search, s->chars, s->length, head + substr.length);
+  }
+  *num_replaced = count;
+  if (count == 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  // error if the result cannot be represented
+  size_t removed = count * substr.length;
+  if (cs.length != 0 && count > (SIZE_MAX - 1 - (s->length - removed)) /
+                                    cs.length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  size_t length = s->length;
+  size_t new_length = (length - removed) + (count * cs.length);
+
+  // a growing result is built from a copy of the contents moved to the end
+  // of the buffer, so that writes never overtake unread chars
+  size_t shift = 0;
+  if (new_length > length) {
+    res = ensure_capacity(s, new_length + 1);
+    if (res.code != STRLIB_E_SUCCESS) {
+      return res;
+    }
+    shift = new_length - length;
+    move_bytes(s->chars + shift, s->chars, length);
+  } else {
+    res = own_chars(s);
+    if (res.code != STRLIB_E_SUCCESS) {
+      return res;
+    }
+  }
+
+  // copy the kept runs and replacements in one sweep
+  const char *in = s->chars + shift;
+  char *out = s->chars;
+  size_t read = 0;
+  for (size_t i = 0; i < count; i++) {
+    head = search_next(&search, in, length, read);
+    move_bytes(out, in + read, head - read);
+    out += head - read;
+    copy_bytes(out, cs.chars, cs.length);
+    out += cs.length;
+    read = head + substr.length;
+  }
+  move_bytes(out, in + read, length - read);
+
+  s->length = new_length;
+  s->chars[new_length] = '\0';
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static size_t slice_low(const strlib_slice_t slice) {
+  return (slice.start < slice.end) ? slice.start : slice.end;
+}
+
+static size_t slice_high(const strlib_slice_t slice) {
+  return (slice.start < slice.end) ? slice.end : slice.start;
+}
+
+static int compare_slices(const void *a, const void *b) {
+  size_t low_a = slice_low(*(const strlib_slice_t *)a);
+  size_t low_b = slice_low(*(const strlib_slice_t *)b);
+  return (low_a > low_b) - (low_a < low_b);
+}
+
+static void finish_compaction(strlib_str_t *s, const size_t write,
+                              const size_t read) {
+  // move the unread tail behind the kept chars and terminate
+  move_bytes(s->chars + write, s->chars + read, s->length - read);
+  s->length = write + (s->length - read);
+  s->chars[s->length] = '\0';
+}
+
+static strlib_result_t remove_substr(strlib_str_t *s,
+                                     const strlib_view_t substr) {
+  assert(s);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  strlib_search_t search;
+  search_init(&search, substr.chars, substr.length);
+
+  // a single read/write cursor sweep drops every match
+  size_t write = 0;
+  size_t read = 0;
+  size_t head = search_next(&search, s->chars, s->length, 0);
+  if (head == STRLIB_NOT_FOUND) {
+    return res;
+  }
+  res = own_chars(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  while (head != STRLIB_NOT_FOUND) {
+    move_bytes(s->chars + write, s->chars + read, head - read);
+    write += head - read;
+    read = head + substr.length;
+    head = search_next(&search, s->chars, s->length, read);
+  }
+  finish_compaction(s, write, read);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t validate_can_store_position(
+    const size_t num_positions, const size_t positions_size) {
+  // raise an error if we are going out of bounds on our positions array
+  if (num_positions >= positions_size) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_SIZE,
+    };
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static void matcher_build_trie(strlib_matcher_build_t *build,
+                               const strlib_matcher_t *matcher,
+                               const strlib_view_t *patterns,
+                               const size_t num_patterns) {
+  // insert the patterns last to first, so that those ending at the same
+  // state are listed in ascending order
+  size_t num_classes = matcher->num_classes;
+  build->num_states = 1;
+  build->first[0] = STRLIB_MATCHER_NONE;
+  for (size_t i = num_patterns; i-- > 0;) {
+    if (patterns[i].length == 0) continue;
+    uint32_t state = 0;
+    for (size_t j = 0; j < patterns[i].length; j++) {
+      unsigned char byte = (unsigned char)patterns[i].chars[j];
+      uint32_t *edge =
+          &build->trie[(state * num_classes) + matcher->classes[byte]];
+      if (*edge == 0) {
+        build->first[build->num_states] = STRLIB_MATCHER_NONE;
+        *edge = (uint32_t)build->num_states++;
+      }
+      state = *edge;
+    }
+    build->same[i] = build->first[state];
+    build->first[state] = (uint32_t)i;
+  }
+}
+
+static strlib_result_t matcher_build_begin(strlib_matcher_build_t *build,
+                                           strlib_matcher_t *matcher,
+                                           const strlib_view_t *patterns,
+                                           const size_t num_patterns) {
+  // at most a state per pattern char, and a class per byte they use
+  bool used[UCHAR_MAX + 1] = {0};
+  size_t max_states = 1;
+  if (num_patterns >= STRLIB_MATCHER_NONE) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_SIZE,
+    };
+  }
+  for (size_t i = 0; i < num_patterns; i++) {
+    if (patterns[i].length >= STRLIB_MATCHER_NONE - max_states) {
+      return (strlib_result_t){
+          .code = STRLIB_E_BAD_SIZE,
+      };
+    }
+    max_states += patterns[i].length;
+    for (size_t j = 0; j < patterns[i].length; j++) {
+      used[(unsigned char)patterns[i].chars[j]] = true;
+    }
+  }
+  matcher->num_classes = 1;
+  for (size_t b = 0; b <= UCHAR_MAX; b++) {
+    if (used[b]) matcher->classes[b] = (uint16_t)matcher->num_classes++;
+  }
+  if (max_states > STRLIB_MATCHER_NONE / matcher->num_classes) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_SIZE,
+    };
+  }
+
+  // the trie is zeroed as 0 marks missing edges
+  *build = (strlib_matcher_build_t){
+      .trie_size = max_states * matcher->num_classes * sizeof(uint32_t),
+      .scratch_size = ((5 * max_states) + num_patterns) * sizeof(uint32_t),
+  };
+  build->trie = (uint32_t *)allocate(&libc_allocator, build->trie_size);
+  build->fail = (uint32_t *)allocate(&libc_allocator, build->scratch_size);
+  if (build->trie == NULL || build->fail == NULL) {
+    if (build->trie != NULL) {
+      deallocate(&libc_allocator, build->trie, build->trie_size);
+    }
+    if (build->fail != NULL) {
+      deallocate(&libc_allocator, build->fail, build->scratch_size);
+    }
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  memset(build->trie, 0, build->trie_size);
+  build->order = build->fail + max_states;
+  build->first = build->order + max_states;
+  build->link = build->first + max_states;
+  build->number = build->link + max_states;
+  build->same = build->number + max_states;
+  matcher_build_trie(build, matcher, patterns, num_patterns);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static void matcher_build_end(strlib_matcher_build_t *build) {
+  deallocate(&libc_allocator, build->trie, build->trie_size);
+  deallocate(&libc_allocator, build->fail, build->scratch_size);
+}
+
+static void matcher_build_links(strlib_matcher_build_t *build,
+                                const size_t num_classes) {
+  // breadth first, so that the row of a failure link is complete by the
+  // time missing edges are taken from it
+  size_t head = 0;
+  size_t tail = 1;
+  build->order[0] = 0;
+  build->fail[0] = 0;
+  build->link[0] = STRLIB_MATCHER_NONE;
+  while (head < tail) {
+    uint32_t state = build->order[head++];
+    uint32_t *row = &build->trie[state * num_classes];
+    const uint32_t *fail_row = &build->trie[build->fail[state] * num_classes];
+    for (size_t c = 0; c < num_classes; c++) {
+      uint32_t child = row[c];
+      if (child == 0) {
+        row[c] = fail_row[c];
+        continue;
+      }
+      uint32_t suffix = (state == 0) ? 0 : fail_row[c];
+      build->fail[child] = suffix;
+      build->link[child] = (build->first[suffix] != STRLIB_MATCHER_NONE)
+                               ? suffix
+                               : build->link[suffix];
+      build->order[tail++] = child;
+    }
+  }
+}
+
+static bool matcher_has_output(const strlib_matcher_build_t *build,
+                               const uint32_t state) {
+  return build->first[state] != STRLIB_MATCHER_NONE ||
+         build->link[state] != STRLIB_MATCHER_NONE;
+}
+
+static size_t matcher_number_states(strlib_matcher_build_t *build) {
+  // states without outputs first, each group in breadth first order
+  size_t first_output = 0;
+  for (size_t i = 0; i < build->num_states; i++) {
+    if (!matcher_has_output(build, (uint32_t)i)) first_output++;
+  }
+  uint32_t plain = 0;
+  uint32_t output = (uint32_t)first_output;
+  for (size_t i = 0; i < build->num_states; i++) {
+    uint32_t state = build->order[i];
+    build->number[state] =
+        matcher_has_output(build, state) ? output++ : plain++;
+  }
+  return first_output;
+}
+
+static void matcher_fill(strlib_matcher_t *matcher,
+                         const strlib_matcher_build_t *build) {
+  // rows move to the number of their state and point at rows by offset
+  size_t num_classes = matcher->num_classes;
+  for (size_t state = 0; state < build->num_states; state++) {
+    const uint32_t *row = &build->trie[state * num_classes];
+    uint32_t *next = &matcher->next[build->number[state] * num_classes];
+    for (size_t c = 0; c < num_classes; c++) {
+      next[c] = build->number[row[c]] * (uint32_t)num_classes;
+    }
+  }
+
+  // outputs are in the order of their states' numbers
+  uint32_t num_ids = 0;
+  for (size_t i = 0; i < build->num_states; i++) {
+    uint32_t state = build->order[i];
+    if (!matcher_has_output(build, state)) continue;
+    strlib_matcher_output_t *output =
+        &matcher->outputs[build->number[state] - matcher->first_output];
+    output->start = num_ids;
+    for (uint32_t id = build->first[state]; id != STRLIB_MATCHER_NONE;
+         id = build->same[id]) {
+      matcher->ids[num_ids++] = id;
+    }
+    output->count = num_ids - output->start;
+    uint32_t link = build->link[state];
+    output->link = (link == STRLIB_MATCHER_NONE)
+                       ? STRLIB_MATCHER_NONE
+                       : build->number[link] - (uint32_t)matcher->first_output;
+  }
+}
+
+static strlib_result_t matcher_scan(const strlib_matcher_t *matcher,
+                                    const char *chars, const size_t length,
+                                    strlib_match_t *matches,
+                                    size_t *num_matches,
+                                    const size_t matches_size) {
+  const uint32_t *next = matcher->next;
+  const uint16_t *classes = matcher->classes;
+  size_t num_classes = matcher->num_classes;
+  size_t first_output = matcher->first_output * num_classes;
+  uint32_t state = 0;
+  *num_matches = 0;
+  for (size_t i = 0; i < length; i++) {
+    state = next[state + classes[(unsigned char)chars[i]]];
+    if (state < first_output) continue;
+
+    // report the patterns ending here, then those ending at its suffixes
+    uint32_t link = (uint32_t)((state / num_classes) - matcher->first_output);
+    while (link != STRLIB_MATCHER_NONE) {
+      const strlib_matcher_output_t *output = &matcher->outputs[link];
+      for (uint32_t k = output->start; k < output->start + output->count;
+           k++) {
+        strlib_result_t res =
+            validate_can_store_position(*num_matches, matches_size);
+        if (res.code != STRLIB_E_SUCCESS) {
+          return res;
+        }
+        uint32_t id = matcher->ids[k];
+        matches[(*num_matches)++] = (strlib_match_t){
+            .pattern = id,
+            .slice = {.start = i + 1 - matcher->lengths[id], .end = i},
+        };
+      }
+      link = output->link;
+    }
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static uint32_t matcher_longest_prefix(const strlib_matcher_build_t *build,
+                                       const strlib_matcher_t *matcher,
+                                       const char *chars, const size_t length,
+                                       size_t *prefix_length) {
+  // follow the trie for as long as it has edges, keeping the last pattern
+  uint32_t state = 0;
+  uint32_t longest = STRLIB_MATCHER_NONE;
+  for (size_t i = 0; i < length; i++) {
+    unsigned char byte = (unsigned char)chars[i];
+    state = build->trie[(state * matcher->num_classes) +
+                        matcher->classes[byte]];
+    if (state == 0) break;
+    if (build->first[state] != STRLIB_MATCHER_NONE) {
+      longest = build->first[state];
+      *prefix_length = i + 1;
+    }
+  }
+  return longest;
+}
+
+static char *rewrite_begin(strlib_str_t *s, const size_t new_length,
+                           char *small, size_t *capacity) {
+  // contents which fit inline are written to `small` first, as the
+  // current contents may be inline too
+  *capacity = STRLIB_SMALL_CAPACITY;
+  if (new_length + 1 <= STRLIB_SMALL_CAPACITY) {
+    return small;
+  }
+
+  // others to a new buffer, reusing the current capacity if it suffices
+  *capacity = (new_length + 1 <= s->capacity)
+                  ? s->capacity
+                  : next_capacity(s->growth, s->capacity, new_length + 1);
+  char *chars = (char *)allocate(s->allocator, *capacity);
+  if (chars == NULL && *capacity > new_length + 1) {
+    *capacity = new_length + 1;
+    chars = (char *)allocate(s->allocator, *capacity);
+  }
+  return chars;
+}
+
+static void rewrite_finish(strlib_str_t *s, char *chars, const char *small,
+                           const size_t capacity, const size_t new_length) {
+  // swap the rewritten contents in for the old ones
+  chars[new_length] = '\0';
+  release_chars(s);
+  if (chars == small) {
+    copy_bytes(s->small, small, new_length + 1);
+    chars = s->small;
+  }
+  s->chars = chars;
+  s->capacity = capacity;
+  s->length = new_length;
+}
+
+static size_t next_candidate(strlib_candidates_t *candidates,
+                             const strlib_view_t in, const size_t from) {
+  while (true) {
+    while (candidates->next < candidates->num_positions) {
+      size_t position = candidates->positions[candidates->next++];
+      if (position >= from) return position;
+    }
+    size_t start = (from > candidates->scanned) ? from : candidates->scanned;
+    if (start >= in.length) return STRLIB_NOT_FOUND;
+
+    // scan up to a full batch ahead, resuming after the last one found
+    candidates->num_positions = 0;
+    candidates->next = 0;
+    bool done = candidates->starts->kernel(
+        candidates->starts, in.chars + start, in.length - start,
+        candidates->positions, &candidates->num_positions,
+        STRLIB_CANDIDATE_BATCH);
+    for (size_t k = 0; k < candidates->num_positions; k++) {
+      candidates->positions[k] += start;
+    }
+    candidates->scanned =
+        done ? in.length
+             : candidates->positions[candidates->num_positions - 1] + 1;
+  }
+}
+
+static void *grow_items(void *items, size_t *capacity, const size_t required,
+                        const size_t item_size) {
+  // double the array until it has room for `required` items
+  if (required <= *capacity) {
+    return items;
+  }
+  size_t new_capacity =
+      (*capacity == 0) ? STRLIB_ITEMS_MIN_CAPACITY : *capacity;
+  while (new_capacity < required) {
+    if (new_capacity > SIZE_MAX / 2) return NULL;
+    new_capacity *= 2;
+  }
+  if (new_capacity > SIZE_MAX / item_size) {
+    return NULL;
+  }
+  void *grown =
+      (items == NULL)
+          ? allocate(&libc_allocator, new_capacity * item_size)
+          : reallocate(&libc_allocator, items, *capacity * item_size,
+                       new_capacity * item_size);
+  if (grown != NULL) {
+    *capacity = new_capacity;
+  }
+  return grown;
+}
+
+static bool slices_push(strlib_slices_t *results, const strlib_slice_t slice) {
+  strlib_slice_t *slices =
+      (strlib_slice_t *)grow_items(results->slices, &results->capacity,
+                                   results->num_slices + 1,
+                                   sizeof(strlib_slice_t));
+  if (slices == NULL) {
+    return false;
+  }
+  results->slices = slices;
+  results->slices[results->num_slices++] = slice;
+  return true;
+}
+
+static strlib_result_t replace_many_length(const strlib_matcher_build_t *build,
+                                           const strlib_matcher_t *matcher,
+                                           const strlib_byte_set_t *starts,
+                                           const strlib_view_t *replacements,
+                                           const strlib_view_t in,
+                                           size_t *new_length,
+                                           size_t *count) {
+  // leftmost-longest matches, only tried where a needle could start
+  strlib_candidates_t candidates = {.starts = starts};
+  *new_length = in.length;
+  *count = 0;
+  size_t i = next_candidate(&candidates, in, 0);
+  while (i != STRLIB_NOT_FOUND) {
+    size_t n = 0;
+    uint32_t id =
+        matcher_longest_prefix(build, matcher, in.chars + i, in.length - i, &n);
+    if (id == STRLIB_MATCHER_NONE) {
+      i = next_candidate(&candidates, in, i + 1);
+      continue;
+    }
+    if (replacements[id].length > SIZE_MAX - 1 - (*new_length - n)) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    *new_length = (*new_length - n) + replacements[id].length;
+    (*count)++;
+    i = next_candidate(&candidates, in, i + n);
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static size_t replace_many_write(const strlib_matcher_build_t *build,
+                                 const strlib_matcher_t *matcher,
+                                 const strlib_byte_set_t *starts,
+                                 const strlib_view_t *replacements,
+                                 const strlib_view_t in, char *out) {
+  // copy the kept runs and replacements in one sweep, which may be in
+  // place as long as no replacement is longer than its needle
+  strlib_candidates_t candidates = {.starts = starts};
+  size_t written = 0;
+  size_t run = 0;
+  size_t i = next_candidate(&candidates, in, 0);
+  while (i != STRLIB_NOT_FOUND) {
+    size_t n = 0;
+    uint32_t id =
+        matcher_longest_prefix(build, matcher, in.chars + i, in.length - i, &n);
+    if (id == STRLIB_MATCHER_NONE) {
+      i = next_candidate(&candidates, in, i + 1);
+      continue;
+    }
+    move_bytes(out + written, in.chars + run, i - run);
+    written += i - run;
+    copy_bytes(out + written, replacements[id].chars,
+               replacements[id].length);
+    written += replacements[id].length;
+    run = i + n;
+    i = next_candidate(&candidates, in, run);
+  }
+  move_bytes(out + written, in.chars + run, in.length - run);
+
+  return written + (in.length - run);
+}
+
+static strlib_result_t replace_many(strlib_str_t *s,
+                                    const strlib_matcher_build_t *build,
+                                    const strlib_matcher_t *matcher,
+                                    const strlib_view_t *needles,
+                                    const strlib_view_t *replacements,
+                                    const size_t num_pairs) {
+  strlib_view_t in = {.chars = s->chars, .length = s->length};
+
+  // matches can only start at the first char of a needle
+  bool seen[UCHAR_MAX + 1] = {0};
+  unsigned char firsts[UCHAR_MAX + 1] = {0};
+  size_t num_firsts = 0;
+  bool grows = false;
+  for (size_t i = 0; i < num_pairs; i++) {
+    if (needles[i].length == 0) continue;
+    unsigned char first = (unsigned char)needles[i].chars[0];
+    if (!seen[first]) {
+      seen[first] = true;
+      firsts[num_firsts++] = first;
+    }
+    if (replacements[i].length > needles[i].length) grows = true;
+  }
+  strlib_byte_set_t starts;
+  byte_set_init(&starts, firsts, num_firsts);
+
+  // shrinking tables are applied in place, in a single pass, unless the
+  // contents are mapped and can be rewritten straight to the heap instead
+  if (!grows && !is_mapped(s)) {
+    s->length =
+        replace_many_write(build, matcher, &starts, replacements, in, s->chars);
+    s->chars[s->length] = '\0';
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  // others are sized first, to be written to a single new buffer
+  size_t new_length = 0;
+  size_t count = 0;
+  strlib_result_t res = replace_many_length(
+      build, matcher, &starts, replacements, in, &new_length, &count);
+  if (res.code != STRLIB_E_SUCCESS || count == 0) {
+    return res;
+  }
+  char small[STRLIB_SMALL_CAPACITY];
+  size_t capacity = 0;
+  char *chars = rewrite_begin(s, new_length, small, &capacity);
+  if (chars == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  replace_many_write(build, matcher, &starts, replacements, in, chars);
+  rewrite_finish(s, chars, small, capacity, new_length);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t edits_add(strlib_edits_t *edits, strlib_edit_t edit,
+                                 const strlib_view_t view) {
+  // copy the chars over first, so a failure leaves the batch as it was
+  if (view.length > SIZE_MAX - edits->num_chars) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  if (view.length != 0) {
+    char *chars = (char *)grow_items(edits->chars, &edits->chars_capacity,
+                                     edits->num_chars + view.length, 1);
+    if (chars == NULL) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    edits->chars = chars;
+  }
+  strlib_edit_t *items = (strlib_edit_t *)grow_items(
+      edits->edits, &edits->edits_capacity, edits->num_edits + 1,
+      sizeof(strlib_edit_t));
+  if (items == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  edits->edits = items;
+
+  if (view.length != 0) {
+    copy_bytes(edits->chars + edits->num_chars, view.chars, view.length);
+  }
+  edit.offset = edits->num_chars;
+  edit.length = view.length;
+  edit.sequence = edits->num_edits;
+  edits->num_chars += view.length;
+  edits->edits[edits->num_edits++] = edit;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static int compare_edits(const void *a, const void *b) {
+  // by position, inserts before the chars replaced there, then in order
+  const strlib_edit_t *x = a;
+  const strlib_edit_t *y = b;
+  if (x->start != y->start) return (x->start < y->start) ? -1 : 1;
+  if (x->insert != y->insert) return x->insert ? -1 : 1;
+  if (x->sequence != y->sequence) return (x->sequence < y->sequence) ? -1 : 1;
+  return 0;
+}
+
+static size_t edit_end(const strlib_edit_t *edit, const size_t length) {
+  // one past the last char replaced, which is never the null terminator
+  if (edit->insert) return edit->start;
+  return (edit->end < length) ? edit->end + 1 : length;
+}
+
+static strlib_result_t edits_validate(const strlib_edits_t *edits,
+                                      const size_t length,
+                                      size_t *new_length) {
+  // error if an edit is out of bounds or overlaps the one before it
+  *new_length = length;
+  size_t read = 0;
+  for (size_t i = 0; i < edits->num_edits; i++) {
+    const strlib_edit_t *edit = &edits->edits[i];
+    if (edit->start > length || edit->end > length || edit->start < read) {
+      return (strlib_result_t){
+          .code = STRLIB_E_BAD_INDEX,
+      };
+    }
+    read = edit_end(edit, length);
+    *new_length -= read - edit->start;
+    if (edit->length > SIZE_MAX - 1 - *new_length) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    *new_length += edit->length;
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static void edits_write(const strlib_edits_t *edits, const strlib_view_t in,
+                        char *out) {
+  // copy the kept runs and the chars of the edits in one sweep
+  size_t read = 0;
+  for (size_t i = 0; i < edits->num_edits; i++) {
+    const strlib_edit_t *edit = &edits->edits[i];
+    copy_bytes(out, in.chars + read, edit->start - read);
+    out += edit->start - read;
+    if (edit->length != 0) {
+      const char *chars = edits->chars + edit->offset;
+      if (edit->reversed) {
+        reverse_copy(out, chars, edit->length);
+      } else {
+        copy_bytes(out, chars, edit->length);
+      }
+    }
+    out += edit->length;
+    read = edit_end(edit, in.length);
+  }
+  copy_bytes(out, in.chars + read, in.length - read);
+}
+
+static void multiply_64(uint64_t *a, uint64_t *b) {
+  // full 128-bit product of `a` and `b`, low half to `a` and high to `b`
+#ifdef __SIZEOF_INT128__
+  __uint128_t product = (__uint128_t)*a * *b;
+  *a = (uint64_t)product;
+  *b = (uint64_t)(product >> 64);
+#else
+  uint64_t a_high = *a >> 32;
+  uint64_t a_low = (uint32_t)*a;
+  uint64_t b_high = *b >> 32;
+  uint64_t b_low = (uint32_t)*b;
+  uint64_t high = a_high * b_high;
+  uint64_t middle_a = a_high * b_low;
+  uint64_t middle_b = b_high * a_low;
+  uint64_t low = a_low * b_low;
+  uint64_t t = low + (middle_a << 32);
+  uint64_t carry = (t < low) ? 1 : 0;
+  uint64_t result_low = t + (middle_b << 32);
+  carry += (result_low < t) ? 1 : 0;
+  *a = result_low;
+  *b = high + (middle_a >> 32) + (middle_b >> 32) + carry;
+#endif
+}
+
+static uint64_t hash_mix(uint64_t a, uint64_t b) {
+  multiply_64(&a, &b);
+  return a ^ b;
+}
+
+static uint64_t read_64(const unsigned char *p) {
+  // little endian on every platform, so that hashes do not differ
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+static uint64_t read_32(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+static uint64_t hash_bytes(const char *chars, const size_t length) {
+  // wyhash: 48 byte blocks go through three independent multiply chains,
+  // shorter tails are folded into the two final words
+  static const uint64_t secret[4] = {
+      0xa0761d6478bd642fu,
+      0xe7037ed1a0b428dbu,
+      0x8ebc6af09c88c6e3u,
+      0x589965cc75374cc3u,
+  };
+  const unsigned char *p = (const unsigned char *)chars;
+  uint64_t seed = hash_mix(secret[0], secret[1]);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (length <= 16) {
+    if (length >= 4) {
+      size_t middle = (length >> 3) << 2;
+      a = (read_32(p) << 32) | read_32(p + middle);
+      b = (read_32(p + length - 4) << 32) | read_32(p + length - 4 - middle);
+    } else if (length > 0) {
+      a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) |
+          p[length - 1];
+    }
+  } else {
+    size_t i = length;
+    if (i > 48) {
+      uint64_t seed1 = seed;
+      uint64_t seed2 = seed;
+      do {
+        seed = hash_mix(read_64(p) ^ secret[1], read_64(p + 8) ^ seed);
+        seed1 = hash_mix(read_64(p + 16) ^ secret[2], read_64(p + 24) ^ seed1);
+        seed2 = hash_mix(read_64(p + 32) ^ secret[3], read_64(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (i > 16) {
+      seed = hash_mix(read_64(p) ^ secret[1], read_64(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = read_64(p + i - 16);
+    b = read_64(p + i - 8);
+  }
+  a ^= secret[1];
+  b ^= seed;
+  multiply_64(&a, &b);
+  return hash_mix(a ^ secret[0] ^ (uint64_t)length, b ^ secret[1]);
+}
+
+static void forget_hash(strlib_str_t *s) {
+  atomic_store_explicit(&s->hash, 0, memory_order_relaxed);
+}
+
+static strlib_result_t init_with_allocator(
+    strlib_str_t **s, const strlib_allocator_t *allocator) {
+  assert(allocator);
+
+  // create space for opaque pointer
+  (*s) = (strlib_str_t *)allocate(allocator, sizeof(strlib_str_t));
+
+  // error if space for opaque pointer cannot be allocated
+  if ((*s) == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  // initialize components, starting out with the inline buffer
+  *(*s) = (strlib_str_t){0};
+  (*s)->allocator = allocator;
+  (*s)->length = 0;
+  (*s)->capacity = STRLIB_SMALL_CAPACITY;
+  (*s)->chars = (*s)->small;
+  (*s)->growth = (strlib_growth_policy_t){
+      .strategy = STRLIB_GROWTH_GEOMETRIC,
+      .limit = 0,
+  };
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t free_str(strlib_str_t *s) {
+  assert(s);
+
+  // free internal chars unless they are stored inline
+  release_chars(s);
+  // free the rope with its buffers and nodes
+  if (s->rope != NULL) {
+    rope_clear(s->rope, s->allocator);
+    while (s->rope->free_nodes != NULL) {
+      strlib_rope_node_t *next = s->rope->free_nodes->left;
+      deallocate(s->allocator, s->rope->free_nodes,
+                 sizeof(strlib_rope_node_t));
+      s->rope->free_nodes = next;
+    }
+    deallocate(s->allocator, s->rope, sizeof(strlib_rope_t));
+  }
+  // free the lock of a shared string
+  if (s->lock != NULL) {
+    (void)pthread_rwlock_destroy(s->lock);
+    deallocate(s->allocator, s->lock, sizeof(pthread_rwlock_t));
+  }
+  // free structure
+  deallocate(s->allocator, s, sizeof(strlib_str_t));
+  // undangle pointer
+  s = NULL;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t arena_get_allocator(
+    strlib_arena_t *arena, const strlib_allocator_t **allocator) {
+  assert(arena);
+  *allocator = &arena->allocator;
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_str_t *intern_find(const strlib_intern_shard_t *shard,
+                                 const uint64_t hash,
+                                 const strlib_view_t view) {
+  // the table is never full, so probing ends at an empty slot
+  if (shard->capacity == 0) return NULL;
+  size_t mask = shard->capacity - 1;
+  for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+    const strlib_intern_slot_t *slot = &shard->slots[i];
+    if (slot->s == NULL) return NULL;
+    if (slot->hash == hash && slot->s->length == view.length &&
+        (view.length == 0 ||
+         memcmp(slot->s->chars, view.chars, view.length) == 0)) {
+      return slot->s;
+    }
+  }
+}
+
+static bool intern_grow(strlib_intern_shard_t *shard) {
+  // keep the load factor at or below 3/4
+  if (shard->count + 1 <= shard->capacity - (shard->capacity / 4)) {
+    return true;
+  }
+  size_t capacity = (shard->capacity == 0) ? STRLIB_ITEMS_MIN_CAPACITY
+                                           : shard->capacity * 2;
+  if (capacity > SIZE_MAX / sizeof(strlib_intern_slot_t)) {
+    return false;
+  }
+  strlib_intern_slot_t *slots = (strlib_intern_slot_t *)allocate(
+      &libc_allocator, capacity * sizeof(strlib_intern_slot_t));
+  if (slots == NULL) {
+    return false;
+  }
+  memset(slots, 0, capacity * sizeof(strlib_intern_slot_t));
+
+  // rehash the strings into the new slots
+  for (size_t i = 0; i < shard->capacity; i++) {
+    if (shard->slots[i].s == NULL) continue;
+    size_t j = (size_t)shard->slots[i].hash & (capacity - 1);
+    while (slots[j].s != NULL) j = (j + 1) & (capacity - 1);
+    slots[j] = shard->slots[i];
+  }
+  if (shard->slots != NULL) {
+    deallocate(&libc_allocator, shard->slots,
+               shard->capacity * sizeof(strlib_intern_slot_t));
+  }
+  shard->slots = slots;
+  shard->capacity = capacity;
+  return true;
+}
+
+static strlib_result_t intern_insert(strlib_intern_shard_t *shard,
+                                     const uint64_t hash,
+                                     const strlib_view_t view,
+                                     const strlib_str_t **interned) {
+  // another thread may have interned the string since it was looked up
+  *interned = intern_find(shard, hash, view);
+  if (*interned != NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+  if (!intern_grow(shard)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  const strlib_allocator_t *allocator = NULL;
+  strlib_result_t res = arena_get_allocator(shard->arena, &allocator);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  strlib_str_t *s = NULL;
+  res = init_with_allocator(&s, allocator);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  s->growth.strategy = STRLIB_GROWTH_EXACT;
+  res = set_chars(s, view.chars, view.length);
+  if (res.code != STRLIB_E_SUCCESS) {
+    free_str(s);
+    return res;
+  }
+  atomic_store_explicit(&s->hash, hash, memory_order_relaxed);
+
+  size_t mask = shard->capacity - 1;
+  size_t i = (size_t)hash & mask;
+  while (shard->slots[i].s != NULL) i = (i + 1) & mask;
+  shard->slots[i] = (strlib_intern_slot_t){
+      .hash = hash,
+      .s = s,
+  };
+  shard->count++;
+  *interned = s;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t append_reserve(strlib_str_t *s, const size_t total) {
+  // flat strings grow once for everything appended, ropes add pieces instead
+  if (total > SIZE_MAX - s->length - 1) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  if (s->rope != NULL) {
+    return rope_activate(s);
+  }
+  return resize_chars(s, total);
+}
+
+static strlib_result_t append_piece(strlib_str_t *s, const char *chars,
+                                    const size_t length) {
+  // copy one piece behind the contents, after append_reserve made room
+  if (length == 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+  if (s->rope != NULL) {
+    return rope_insert(s, chars, length, s->length, false);
+  }
+  copy_bytes(s->chars + s->length, chars, length);
+  s->length += length;
+  s->chars[s->length] = '\0';
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t append_views(strlib_str_t *s,
+                                    const strlib_view_t *parts,
+                                    const size_t num_parts,
+                                    const strlib_view_t separator) {
+  // total the parts and separators first, erroring if it overflows
+  size_t total = 0;
+  for (size_t i = 0; i < num_parts; i++) {
+    size_t length = parts[i].length;
+    if (i > 0) {
+      if (separator.length > SIZE_MAX - length) {
+        return (strlib_result_t){
+            .code = STRLIB_E_NO_MEMORY,
+        };
+      }
+      length += separator.length;
+    }
+    if (length > SIZE_MAX - total) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    total += length;
+  }
+  if (total == 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  strlib_result_t res = append_reserve(s, total);
+  for (size_t i = 0; i < num_parts && res.code == STRLIB_E_SUCCESS; i++) {
+    if (i > 0) {
+      res = append_piece(s, separator.chars, separator.length);
+    }
+    if (res.code == STRLIB_E_SUCCESS) {
+      res = append_piece(s, parts[i].chars, parts[i].length);
+    }
+  }
+
+  return res;
+}
+
+static int compare_chars(const char *a, const size_t a_length,
+                         const char *b, const size_t b_length) {
+  // compare the common prefix, then order a shorter prefix first
+  size_t common = (a_length < b_length) ? a_length : b_length;
+  int cmp = (common == 0) ? 0 : memcmp(a, b, common);
+  if (cmp == 0 && a_length != b_length) {
+    cmp = (a_length < b_length) ? -1 : 1;
+  }
+  return (cmp > 0) - (cmp < 0);
+}
+
+static bool hashes_differ(const strlib_str_t *a, const strlib_str_t *b) {
+  // true only if both hashes are cached and tell the contents apart
+  uint64_t a_hash = atomic_load_explicit(&a->hash, memory_order_relaxed);
+  uint64_t b_hash = atomic_load_explicit(&b->hash, memory_order_relaxed);
+  return a_hash != 0 && b_hash != 0 && a_hash != b_hash;
+}
+
+static int compare_guarded(const void *a, const void *b) {
+  // order guards by the address of the string they are to lock
+  uintptr_t x = (uintptr_t)((const strlib_guard_t *)a)->s;
+  uintptr_t y = (uintptr_t)((const strlib_guard_t *)b)->s;
+  return (x > y) - (x < y);
+}
+
+static bool lock_shared(strlib_str_t *const *strs, const size_t count,
+                        strlib_guard_t **guards, size_t *num_guards) {
+  // shared strings are locked in address order, as pairs are, so that
+  // threads locking several of them never wait on each other in a cycle
+  *guards = NULL;
+  *num_guards = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (strs[i]->lock != NULL) (*num_guards)++;
+  }
+  if (*num_guards == 0) return true;
+
+  *guards = (strlib_guard_t *)allocate(&libc_allocator,
+                                       *num_guards * sizeof(strlib_guard_t));
+  if (*guards == NULL) return false;
+  size_t k = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (strs[i]->lock != NULL) {
+      (*guards)[k++] = (strlib_guard_t){.s = strs[i], .prev = NULL};
+    }
+  }
+  qsort(*guards, *num_guards, sizeof(strlib_guard_t), compare_guarded);
+  for (k = 0; k < *num_guards; k++) {
+    // strings listed twice are held already and leave their guard empty
+    const strlib_str_t *shared = (*guards)[k].s;
+    (*guards)[k] = (strlib_guard_t){0};
+    guard_lock(&(*guards)[k], shared, false);
+  }
+  return true;
+}
+
+static void unlock_shared(strlib_guard_t *guards, size_t num_guards) {
+  // guards are held as a stack, so they are released in reverse
+  if (guards == NULL) return;
+  for (size_t k = num_guards; k > 0; k--) {
+    guard_unlock(&guards[k - 1]);
+  }
+  deallocate(&libc_allocator, guards, num_guards * sizeof(strlib_guard_t));
+}
+
+static void sort_load_keys(strlib_sort_entry_t *entries, const size_t count,
+                           const size_t depth) {
+  // cache the 8 chars of every entry from `depth`, which is a multiple of 8
+  for (size_t i = 0; i < count; i++) {
+    strlib_sort_entry_t *entry = &entries[i];
+    size_t left = (entry->length > depth) ? entry->length - depth : 0;
+    const unsigned char *p = (const unsigned char *)entry->chars + depth;
+    if (left >= 8) {
+      entry->key = __builtin_bswap64(read_64(p));
+      continue;
+    }
+    entry->key = 0;
+    for (size_t j = 0; j < left; j++) {
+      entry->key |= (uint64_t)p[j] << (56 - (8 * j));
+    }
+  }
+}
+
+static int sort_compare(const strlib_sort_entry_t *a,
+                        const strlib_sort_entry_t *b, const size_t depth) {
+  // keys differ only where the chars do, as padding orders like an end
+  if (a->key != b->key) return (a->key < b->key) ? -1 : 1;
+  return compare_chars(a->chars + depth, a->length - depth, b->chars + depth,
+                       b->length - depth);
+}
+
+static void sort_small(strlib_sort_entry_t *entries, const size_t count,
+                       const size_t depth) {
+  // insertion sort of entries sharing their first `depth` chars
+  for (size_t i = 1; i < count; i++) {
+    strlib_sort_entry_t entry = entries[i];
+    size_t j = i;
+    while (j > 0 && sort_compare(&entries[j - 1], &entry, depth) > 0) {
+      entries[j] = entries[j - 1];
+      j--;
+    }
+    entries[j] = entry;
+  }
+}
+
+static size_t sort_bucket(const strlib_sort_entry_t *entry,
+                          const size_t depth) {
+  // strings ending before `depth` go first, the others by their char there
+  if (entry->length <= depth) return 0;
+  return ((entry->key >> (56 - (8 * (depth & 7)))) & 0xff) + 1;
+}
+
+static void sort_radix(strlib_sort_entry_t *entries,
+                       strlib_sort_entry_t *temp, size_t count,
+                       size_t depth) {
+  // distribute entries sharing their first `depth` chars by the next one,
+  // recursing on all buckets but the largest, which is iterated on, so that
+  // the recursion stays logarithmic in `count`
+  for (;;) {
+    if ((depth & 7) == 0) sort_load_keys(entries, count, depth);
+    if (count <= STRLIB_SORT_INSERTION) {
+      sort_small(entries, count, depth);
+      return;
+    }
+
+    size_t counts[257] = {0};
+    for (size_t i = 0; i < count; i++) {
+      counts[sort_bucket(&entries[i], depth)]++;
+    }
+    size_t first = sort_bucket(&entries[0], depth);
+    if (counts[first] == count) {
+      // strings that all ended are equal, others share one more char
+      if (first == 0) return;
+      depth++;
+      continue;
+    }
+
+    size_t starts[257];
+    size_t next[257];
+    size_t largest = 1;
+    starts[0] = 0;
+    for (size_t b = 1; b < 257; b++) {
+      starts[b] = starts[b - 1] + counts[b - 1];
+      if (counts[b] > counts[largest]) largest = b;
+    }
+    memcpy(next, starts, sizeof(next));
+    for (size_t i = 0; i < count; i++) {
+      temp[next[sort_bucket(&entries[i], depth)]++] = entries[i];
+    }
+    memcpy(entries, temp, count * sizeof(strlib_sort_entry_t));
+
+    for (size_t b = 1; b < 257; b++) {
+      if (b != largest && counts[b] > 1) {
+        sort_radix(entries + starts[b], temp, counts[b], depth + 1);
+      }
+    }
+    entries += starts[largest];
+    count = counts[largest];
+    depth++;
+  }
+}
+
+static strlib_result_t validate_str_slice(const strlib_str_t *s,
+                                          const strlib_slice_t slice) {
+  // error if trying to get position outside of string
+  if (slice.start > s->length || slice.end > s->length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_INDEX,
+    };
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t get_slice_length_and_capacity(const strlib_slice_t slice,
+                                                     size_t *length,
+                                                     size_t *capacity) {
+  // error if buffer is not large enough to hold slice
+  size_t req_length = slice.end > slice.start ? (slice.end - slice.start) + 1
+                                              : (slice.start - slice.end) + 1;
+  *length = req_length;
+  *capacity = req_length + 1;
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t validate_buffer_can_hold_slice(const size_t buf_size,
+                                                      const size_t slice_size) {
+  // error if buffer is not large enough to hold slice
+  if (buf_size < slice_size) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_SIZE,
+    };
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t read_characters_from_position(const strlib_str_t *s,
+                                                     char *buf,
+                                                     const size_t num_to_read,
+                                                     const size_t position,
+                                                     const bool reversed) {
+  // copy the slice from start to finish, a reversed slice ends at position
+  if (is_rope(s)) {
+    rope_read(s, buf, reversed ? position + 1 - num_to_read : position,
+              num_to_read, reversed);
+  } else if (reversed) {
+    reverse_copy(buf, s->chars + (position + 1 - num_to_read), num_to_read);
+  } else {
+    copy_bytes(buf, s->chars + position, num_to_read);
+  }
+  // write null terminator
+  buf[num_to_read] = '\0';
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t copy_chars_x_over_left_starting_at_position(
+    strlib_str_t *s, const size_t x, const size_t position) {
+  // copy all trailing characters from position forward
+  size_t end = position + x;
+  if (end <= s->length) {
+    move_bytes(s->chars + position, s->chars + end, (s->length - end) + 1);
+  }
+
+  // write the null terminator and bump length
+  s->length = s->length - x;
+  s->chars[s->length] = '\0';
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+/*******************************************************************************/
+static strlib_result_t get_slice(const strlib_str_t *s, char *buf,
+                                 const size_t size,
+                                 const strlib_slice_t slice) {
+  assert(s);
+  STRLIB_LOCK(s, false);
+  size_t slice_length = 0;
+  size_t slice_capacity = 0;
+
+  strlib_result_t res =
+      get_slice_length_and_capacity(slice, &slice_length, &slice_capacity);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  res = validate_str_slice(s, slice);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  res = validate_buffer_can_hold_slice(size, slice_capacity);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  res = read_characters_from_position(s, buf, slice_length, slice.start,
+                                      (slice.start > slice.end));
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t insert_chars(strlib_str_t *s, const char *cs,
+                                    const size_t len_cs, const size_t position,
+                                    const bool reversed) {
+  assert(s);
+  STRLIB_MODIFY(s);
+
+  strlib_result_t res = validate_insert_position(s, position);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // ropes insert a new piece rather than moving the tail of the string
+  if (s->rope != NULL) {
+    if (len_cs > SIZE_MAX - s->length - 1) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    return rope_insert(s, cs, len_cs, position, reversed);
+  }
+
+  res = resize_chars(s, len_cs);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  res = shift_chars_right_by_x_from_position(s, len_cs, position);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  res = write_characters_to_position(s, cs, len_cs, position, reversed);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t remove_slice(strlib_str_t *s,
+                                    const strlib_slice_t slice) {
+  assert(s);
+  STRLIB_MODIFY(s);
+
+  strlib_result_t res = validate_str_slice(s, slice);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // the null terminator at index length is never removed
+  size_t start = slice_low(slice);
+  size_t end = (slice_high(slice) < s->length) ? slice_high(slice) + 1
+                                               : s->length;
+  if (start >= end) {
+    return res;
+  }
+  size_t size = end - start;
+
+  if (s->rope != NULL) {
+    return rope_remove(s, start, size);
+  }
+
+  res = own_chars(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  res = copy_chars_x_over_left_starting_at_position(s, size, start);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t replace_slice_view(strlib_str_t *s,
+                                          const strlib_view_t view,
+                                          const strlib_slice_t slice) {
+  assert(s);
+  STRLIB_MODIFY(s);
+
+  strlib_result_t result = remove_slice(s, slice);
+  if (result.code != STRLIB_E_SUCCESS) {
+    return result;
+  }
+
+  result = insert_chars(
+      s, view.chars, view.length,
+      (slice.start > slice.end) ? slice.end : slice.start,
+      (slice.start > slice.end));
+  if (result.code != STRLIB_E_SUCCESS) {
+    return result;
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t replace_slice_n(strlib_str_t *s, const char *cs,
+                                       const size_t cs_length,
+                                       const strlib_slice_t slice) {
+  STRLIB_MODIFY(s);
+  return replace_slice_view(
+      s, (strlib_view_t){.chars = cs, .length = cs_length}, slice);
+}
+
+static strlib_result_t find_substr_view(strlib_str_t *s,
+                                        strlib_slice_t *slices,
+                                        size_t *num_positions,
+                                        const size_t positions_size,
+                                        const strlib_view_t substr) {
+  assert(s);
+  STRLIB_LOCK(s, false);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // initialize substring finding
+  strlib_search_t search;
+  search_init(&search, substr.chars, substr.length);
+  *num_positions = 0;
+  size_t head = search_next(&search, s->chars, s->length, 0);
+
+  // while there are more substrings
+  while (head != STRLIB_NOT_FOUND) {
+    res = validate_can_store_position(*num_positions, positions_size);
+    if (res.code != STRLIB_E_SUCCESS) {
+      return res;
+    }
+
+    // add found position to positions array and increment positions counter
+    slices[(*num_positions)++] = (strlib_slice_t){
+        .start = head,
+        .end = head + (substr.length - 1),
+    };
+
+    // attempt to find next substring by incrementing one past current
+    // substring
+    head = search_next(&search, s->chars, s->length, head + 1);
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t find_substr_n(strlib_str_t *s, strlib_slice_t *slices,
+                                     size_t *num_positions,
+                                     const size_t positions_size,
+                                     const char *substr,
+                                     const size_t substr_length) {
+  STRLIB_LOCK(s, false);
+  return find_substr_view(
+      s, slices, num_positions, positions_size,
+      (strlib_view_t){.chars = substr, .length = substr_length});
+}
+
+static strlib_result_t find_any_char_n(strlib_str_t *s, size_t *positions,
+                                       size_t *num_positions,
+                                       const size_t positions_size,
+                                       const char *set,
+                                       const size_t set_length) {
+  STRLIB_LOCK(s, false);
+  return find_byte_set(s, positions, num_positions, positions_size,
+                       (const unsigned char *)set, set_length);
+}
+
+static strlib_result_t find_all_any_char_n(strlib_str_t *s,
+                                           strlib_slices_t *results,
+                                           const char *set,
+                                           const size_t set_length) {
+  assert(s);
+  assert(results);
+  STRLIB_LOCK(s, false);
+  results->num_slices = 0;
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // scan a batch of positions at a time
+  strlib_byte_set_t bytes;
+  byte_set_init(&bytes, (const unsigned char *)set, set_length);
+  strlib_candidates_t candidates = {.starts = &bytes};
+  strlib_view_t in = {.chars = s->chars, .length = s->length};
+  size_t position = next_candidate(&candidates, in, 0);
+  while (position != STRLIB_NOT_FOUND) {
+    if (!slices_push(results,
+                     (strlib_slice_t){.start = position, .end = position})) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    position = next_candidate(&candidates, in, position + 1);
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t replace_substr_max_n(strlib_str_t *s,
+                                            const char *substr,
+                                            const size_t substr_length,
+                                            const char *cs,
+                                            const size_t cs_length,
+                                            const size_t max_replacements,
+                                            size_t *num_replaced) {
+  STRLIB_MODIFY(s);
+  return replace_substr(
+      s, (strlib_view_t){.chars = substr, .length = substr_length},
+      (strlib_view_t){.chars = cs, .length = cs_length}, max_replacements,
+      num_replaced);
+}
+
+static strlib_result_t remove_substr_n(strlib_str_t *s, const char *substr,
+                                       const size_t substr_length) {
+  STRLIB_MODIFY(s);
+  return remove_substr(
+      s, (strlib_view_t){.chars = substr, .length = substr_length});
+}
+
+static strlib_result_t remove_any_char_n(strlib_str_t *s, const char *set,
+                                         const size_t set_length) {
+  assert(s);
+  STRLIB_MODIFY(s);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  res = own_chars(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  strlib_byte_set_t bytes;
+  byte_set_init(&bytes, (const unsigned char *)set, set_length);
+
+  // branch-free compaction: every char is written, only kept ones advance
+  unsigned char *chars = (unsigned char *)s->chars;
+  size_t write = 0;
+  for (size_t read = 0; read < s->length; read++) {
+    unsigned char c = chars[read];
+    chars[write] = c;
+    write += bytes.member[c] ? 0 : 1;
+  }
+  finish_compaction(s, write, s->length);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t map_file(strlib_str_t *s, const int fd) {
+  assert(s);
+  STRLIB_MODIFY(s);
+
+  // error unless a regular file is given
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_IO,
+    };
+  }
+  long page = sysconf(_SC_PAGESIZE);
+  if (page <= 0 || (uintmax_t)st.st_size > SIZE_MAX - (size_t)page) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  size_t length = (size_t)st.st_size;
+  if (length == 0) {
+    return set_chars(s, NULL, 0);
+  }
+
+  // the file is mapped over zeroed pages one byte longer, so that the null
+  // terminator is readable even when the file fills its last page
+  size_t map_size = ((length / (size_t)page) + 1) * (size_t)page;
+  void *chars = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1, 0);
+  if (chars == MAP_FAILED) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  if (mmap(chars, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) ==
+      MAP_FAILED) {
+    (void)munmap(chars, map_size);
+    return (strlib_result_t){
+        .code = STRLIB_E_IO,
+    };
+  }
+
+  // the old contents are dropped, as strlib_set would
+  if (is_rope(s)) {
+    rope_clear(s->rope, s->allocator);
+    s->rope->active = false;
+  }
+  release_chars(s);
+  s->chars = (char *)chars;
+  s->length = length;
+  s->capacity = 0;
+  s->map_size = map_size;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t intern_view(strlib_intern_t *table,
+                                   const strlib_view_t view,
+                                   const strlib_str_t **interned) {
+  assert(table);
+  assert(interned);
+  uint64_t hash = hash_bytes(view.chars, view.length);
+  strlib_intern_shard_t *shard =
+      &table->shards[hash >> (64 - STRLIB_INTERN_SHARD_BITS)];
+
+  // strings interned already are found in parallel under the read lock
+  int rc = pthread_rwlock_rdlock(&shard->lock);
+  assert(rc == 0);
+  *interned = intern_find(shard, hash, view);
+  (void)pthread_rwlock_unlock(&shard->lock);
+  if (*interned != NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  rc = pthread_rwlock_wrlock(&shard->lock);
+  assert(rc == 0);
+  (void)rc;
+  strlib_result_t res = intern_insert(shard, hash, view, interned);
+  (void)pthread_rwlock_unlock(&shard->lock);
+
+  return res;
+}
+
+static strlib_result_t arena_init(strlib_arena_t **arena,
+                                  const size_t block_size) {
+  // error if the arena could never hand out memory
+  if (block_size == 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_SIZE,
+    };
+  }
+
+  (*arena) = (strlib_arena_t *)calloc(1, sizeof(strlib_arena_t));
+  if ((*arena) == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  // blocks are only requested once memory is needed
+  (*arena)->allocator = (strlib_allocator_t){
+      .alloc = arena_alloc,
+      .resize = arena_resize,
+      .release = arena_release,
+      .ctx = (*arena),
+  };
+  (*arena)->block_size = block_size;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+static strlib_result_t arena_free(strlib_arena_t *arena) {
+  assert(arena);
+
+  strlib_arena_block_t *block = arena->blocks;
+  while (block != NULL) {
+    strlib_arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(arena);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+
+/*
+** Functions which are provided by strlib to be used by external callers.
+*/
+
+strlib_result_t strlib_init(strlib_str_t **s) {
+  STRLIB_PROBE(init);
+  return init_with_allocator(s, &libc_allocator);
+}
+
+strlib_result_t strlib_init_with_allocator(
+    strlib_str_t **s, const strlib_allocator_t *allocator) {
+  STRLIB_PROBE(init_with_allocator);
+  return init_with_allocator(s, allocator);
+}
+
+strlib_result_t strlib_init_with_representation(
+    strlib_str_t **s, const strlib_representation_t representation,
+    const strlib_allocator_t *allocator) {
+  STRLIB_PROBE(init_with_representation);
+  if (allocator == NULL) {
+    allocator = &libc_allocator;
+  }
+  strlib_result_t res = init_with_allocator(s, allocator);
+  if (res.code != STRLIB_E_SUCCESS ||
+      representation == STRLIB_REPRESENTATION_FLAT) {
+    return res;
+  }
+
+  // rope strings start out flat and hand their contents to the rope on the
+  // first edit
+  strlib_rope_t *rope =
+      (strlib_rope_t *)allocate(allocator, sizeof(strlib_rope_t));
+  if (rope == NULL) {
+    free_str(*s);
+    *s = NULL;
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  *rope = (strlib_rope_t){0};
+  rope->seed = 0x9e3779b9u;
+  (*s)->rope = rope;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_share(strlib_str_t *s) {
+  STRLIB_PROBE(share);
+  assert(s);
+  if (s->lock != NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  pthread_rwlock_t *lock =
+      (pthread_rwlock_t *)allocate(s->allocator, sizeof(pthread_rwlock_t));
+  if (lock == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  if (pthread_rwlock_init(lock, NULL) != 0) {
+    deallocate(s->allocator, lock, sizeof(pthread_rwlock_t));
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  s->lock = lock;
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_init_from_file(strlib_str_t **s, const char *path,
+                                      const strlib_allocator_t *allocator) {
+  STRLIB_PROBE(init_from_file);
+  assert(path);
+  if (allocator == NULL) {
+    allocator = &libc_allocator;
+  }
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    *s = NULL;
+    return (strlib_result_t){
+        .code = STRLIB_E_IO,
+    };
+  }
+  strlib_result_t res = init_with_allocator(s, allocator);
+  if (res.code == STRLIB_E_SUCCESS) {
+    res = map_file(*s, fd);
+    if (res.code != STRLIB_E_SUCCESS) {
+      free_str(*s);
+      *s = NULL;
+    }
+  }
+  // the mapping outlives the descriptor
+  (void)close(fd);
+
+  return res;
+}
+
+strlib_result_t strlib_map(strlib_str_t *s, const int fd) {
+  STRLIB_PROBE(map);
+  return map_file(s, fd);
+}
+
+strlib_result_t strlib_find_char(strlib_str_t *s, size_t *positions,
+                                 size_t *num_positions,
+                                 const size_t positions_size, const char c) {
+  STRLIB_PROBE(find_char);
+  STRLIB_LOCK(s, false);
+  unsigned char byte = (unsigned char)c;
+  return find_byte_set(s, positions, num_positions, positions_size, &byte, 1);
+}
+
+strlib_result_t strlib_find_any_char(strlib_str_t *s, size_t *positions,
+                                     size_t *num_positions,
+                                     const size_t positions_size,
+                                     const char *set) {
+  STRLIB_PROBE(find_any_char);
+  STRLIB_LOCK(s, false);
+  return find_any_char_n(s, positions, num_positions, positions_size, set,
+                         strlen(set));
+}
+
+strlib_result_t strlib_find_any_char_n(strlib_str_t *s, size_t *positions,
+                                       size_t *num_positions,
+                                       const size_t positions_size,
+                                       const char *set,
+                                       const size_t set_length) {
+  STRLIB_PROBE(find_any_char_n);
+  return find_any_char_n(s, positions, num_positions, positions_size, set,
+                         set_length);
+}
+
+strlib_result_t strlib_find_substr(strlib_str_t *s, strlib_slice_t *slices,
+                                   size_t *num_positions,
+                                   const size_t positions_size,
+                                   const char *substr) {
+  STRLIB_PROBE(find_substr);
+  STRLIB_LOCK(s, false);
+  return find_substr_n(s, slices, num_positions, positions_size, substr,
+                       strlen(substr));
+}
+
+strlib_result_t strlib_find_substr_n(strlib_str_t *s, strlib_slice_t *slices,
+                                     size_t *num_positions,
+                                     const size_t positions_size,
+                                     const char *substr,
+                                     const size_t substr_length) {
+  STRLIB_PROBE(find_substr_n);
+  return find_substr_n(s, slices, num_positions, positions_size, substr,
+                       substr_length);
+}
+
+strlib_result_t strlib_find_substr_view(strlib_str_t *s,
+                                        strlib_slice_t *slices,
+                                        size_t *num_positions,
+                                        const size_t positions_size,
+                                        const strlib_view_t substr) {
+  STRLIB_PROBE(find_substr_view);
+  return find_substr_view(s, slices, num_positions, positions_size, substr);
+}
+
+strlib_result_t strlib_find_all(strlib_str_t *s, strlib_slices_t *results,
+                                const strlib_view_t substr) {
+  STRLIB_PROBE(find_all);
+  assert(s);
+  assert(results);
+  STRLIB_LOCK(s, false);
+  results->num_slices = 0;
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // collect every match, overlapping ones included
+  strlib_search_t search;
+  search_init(&search, substr.chars, substr.length);
+  size_t head = search_next(&search, s->chars, s->length, 0);
+  while (head != STRLIB_NOT_FOUND) {
+    if (!slices_push(results, (strlib_slice_t){
+                                  .start = head,
+                                  .end = head + (substr.length - 1),
+                              })) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    head = search_next(&search, s->chars, s->length, head + 1);
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_find_all_any_char(strlib_str_t *s,
+                                         strlib_slices_t *results,
+                                         const char *set) {
+  STRLIB_PROBE(find_all_any_char);
+  STRLIB_LOCK(s, false);
+  return find_all_any_char_n(s, results, set, strlen(set));
+}
+
+strlib_result_t strlib_find_all_any_char_n(strlib_str_t *s,
+                                           strlib_slices_t *results,
+                                           const char *set,
+                                           const size_t set_length) {
+  STRLIB_PROBE(find_all_any_char_n);
+  return find_all_any_char_n(s, results, set, set_length);
+}
+
+strlib_result_t strlib_slices_free(strlib_slices_t *results) {
+  STRLIB_PROBE(slices_free);
+  assert(results);
+  if (results->slices != NULL) {
+    deallocate(&libc_allocator, results->slices,
+               results->capacity * sizeof(strlib_slice_t));
+  }
+  *results = (strlib_slices_t){0};
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_finder_init(strlib_finder_t **finder,
+                                   const strlib_view_t needle) {
+  STRLIB_PROBE(finder_init);
+  assert(finder);
+
+  // the needle is kept after the header
+  if (needle.length > SIZE_MAX - sizeof(strlib_finder_t)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  size_t size = sizeof(strlib_finder_t) + needle.length;
+  (*finder) = (strlib_finder_t *)allocate(&libc_allocator, size);
+  if ((*finder) == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+
+  char *chars = (char *)(*finder) + sizeof(strlib_finder_t);
+  if (needle.length != 0) {
+    copy_bytes(chars, needle.chars, needle.length);
+  }
+  *(*finder) = (strlib_finder_t){
+      .position = 0,
+      .size = size,
+  };
+  search_init(&(*finder)->search, chars, needle.length);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_find_next(strlib_finder_t *finder, strlib_str_t *s,
+                                 strlib_slice_t *match, bool *found) {
+  STRLIB_PROBE(find_next);
+  assert(finder);
+  assert(s);
+  STRLIB_LOCK(s, false);
+  *found = false;
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // resume one past the start of the last match
+  size_t head = search_next(&finder->search, s->chars, s->length,
+                            finder->position);
+  if (head != STRLIB_NOT_FOUND) {
+    *match = (strlib_slice_t){
+        .start = head,
+        .end = head + (finder->search.length - 1),
+    };
+    *found = true;
+    finder->position = head + 1;
+  }
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_finder_seek(strlib_finder_t *finder,
+                                   const size_t position) {
+  STRLIB_PROBE(finder_seek);
+  assert(finder);
+  finder->position = position;
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_finder_free(strlib_finder_t *finder) {
+  STRLIB_PROBE(finder_free);
+  assert(finder);
+  deallocate(&libc_allocator, finder, finder->size);
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_insert_char(strlib_str_t *s, const char c,
+                                   const size_t position) {
+  STRLIB_PROBE(insert_char);
+  STRLIB_MODIFY(s);
+  return insert_chars(s, &c, 1, position, false);
+}
+
+strlib_result_t strlib_insert_chars(strlib_str_t *s, const char *cs,
+                                    const size_t len_cs, const size_t position,
+                                    const bool reversed) {
+  STRLIB_PROBE(insert_chars);
+  return insert_chars(s, cs, len_cs, position, reversed);
+}
+
+strlib_result_t strlib_insert_view(strlib_str_t *s, const strlib_view_t view,
+                                   const size_t position) {
+  STRLIB_PROBE(insert_view);
+  STRLIB_MODIFY(s);
+  return insert_chars(s, view.chars, view.length, position, false);
+}
+
+strlib_result_t strlib_get(const strlib_str_t *s, char *buf,
+                           const size_t size) {
+  STRLIB_PROBE(get);
+  STRLIB_LOCK(s, false);
+  return get_slice(s, buf, size,
+                   (strlib_slice_t){.start = 0, .end = s->length});
+}
+
+strlib_result_t strlib_get_char(const strlib_str_t *s, char *c,
+                                const size_t position) {
+  STRLIB_PROBE(get_char);
+  STRLIB_LOCK(s, false);
+  // I need a null terminator for uniformity
+  char cs[2] = {0};
+
+  strlib_result_t res = get_slice(
+      s, cs, 2, (strlib_slice_t){.start = position, .end = position});
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  *c = cs[0];
+  return res;
+}
+
+strlib_result_t strlib_get_slice(const strlib_str_t *s, char *buf,
+                                 const size_t size,
+                                 const strlib_slice_t slice) {
+  STRLIB_PROBE(get_slice);
+  return get_slice(s, buf, size, slice);
+}
+
+strlib_result_t strlib_get_view(const strlib_str_t *s, strlib_view_t *view) {
+  STRLIB_PROBE(get_view);
+  assert(s);
+  STRLIB_LOCK(s, false);
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(s, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  *view = (strlib_view_t){
+      .chars = chars,
+      .length = s->length,
+  };
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_get_slice_view(const strlib_str_t *s,
+                                      strlib_view_t *view,
+                                      const strlib_slice_t slice) {
+  STRLIB_PROBE(get_slice_view);
+  assert(s);
+  STRLIB_LOCK(s, false);
+
+  // error if the slice is reversed or reaches past the contents, as neither
+  // can be borrowed without copying
+  if (slice.start > slice.end || slice.end >= s->length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_INDEX,
+    };
+  }
+
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(s, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  *view = (strlib_view_t){
+      .chars = chars + slice.start,
+      .length = (slice.end - slice.start) + 1,
+  };
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_compare_view(const strlib_str_t *s,
+                                    const strlib_view_t view, int *result) {
+  STRLIB_PROBE(compare_view);
+  assert(s);
+  STRLIB_LOCK(s, false);
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(s, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  *result = compare_chars(chars, s->length, view.chars, view.length);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_compare(const strlib_str_t *a, const strlib_str_t *b,
+                               int *result) {
+  STRLIB_PROBE(compare);
+  assert(a);
+  assert(b);
+  assert(result);
+  STRLIB_LOCK_PAIR(a, false, b, false);
+  const char *a_chars = NULL;
+  const char *b_chars = NULL;
+  strlib_result_t res = borrow_chars(a, &a_chars);
+  if (res.code == STRLIB_E_SUCCESS) res = borrow_chars(b, &b_chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  *result = compare_chars(a_chars, a->length, b_chars, b->length);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_equals(const strlib_str_t *a, const strlib_str_t *b,
+                              bool *result) {
+  STRLIB_PROBE(equals);
+  assert(a);
+  assert(b);
+  assert(result);
+  STRLIB_LOCK_PAIR(a, false, b, false);
+
+  // lengths and cached hashes tell most strings apart without reading them
+  *result = false;
+  if (a->length != b->length || hashes_differ(a, b)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+  const char *a_chars = NULL;
+  const char *b_chars = NULL;
+  strlib_result_t res = borrow_chars(a, &a_chars);
+  if (res.code == STRLIB_E_SUCCESS) res = borrow_chars(b, &b_chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  *result = (a == b) || (a->length == 0) ||
+            (memcmp(a_chars, b_chars, a->length) == 0);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_equals_view(const strlib_str_t *s,
+                                   const strlib_view_t view, bool *result) {
+  STRLIB_PROBE(equals_view);
+  assert(s);
+  assert(result);
+  STRLIB_LOCK(s, false);
+
+  *result = false;
+  if (s->length != view.length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(s, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  *result = (view.length == 0) || (memcmp(chars, view.chars, view.length) == 0);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_starts_with(const strlib_str_t *s,
+                                   const strlib_view_t prefix, bool *result) {
+  STRLIB_PROBE(starts_with);
+  assert(s);
+  assert(result);
+  STRLIB_LOCK(s, false);
+
+  *result = false;
+  if (s->length < prefix.length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(s, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  *result = (prefix.length == 0) ||
+            (memcmp(chars, prefix.chars, prefix.length) == 0);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_ends_with(const strlib_str_t *s,
+                                 const strlib_view_t suffix, bool *result) {
+  STRLIB_PROBE(ends_with);
+  assert(s);
+  assert(result);
+  STRLIB_LOCK(s, false);
+
+  *result = false;
+  if (s->length < suffix.length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(s, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  *result = (suffix.length == 0) ||
+            (memcmp(chars + (s->length - suffix.length), suffix.chars,
+                    suffix.length) == 0);
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_sort(strlib_str_t **strs, const size_t count) {
+  STRLIB_PROBE(sort);
+  assert(strs || count == 0);
+  if (count < 2) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  // error if the entries and their scratch copy cannot be sized
+  if (count > SIZE_MAX / (2 * sizeof(strlib_sort_entry_t))) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  size_t size = 2 * count * sizeof(strlib_sort_entry_t);
+  strlib_sort_entry_t *entries =
+      (strlib_sort_entry_t *)allocate(&libc_allocator, size);
+  if (entries == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
   }
 
-  // error if space for char array isn't allocated
-  if (s->chars == NULL) {
+  // the chars are borrowed for the whole sort, so shared strings stay
+  // locked until the order is written back
+  strlib_guard_t *guards = NULL;
+  size_t num_guards = 0;
+  if (!lock_shared(strs, count, &guards, &num_guards)) {
+    deallocate(&libc_allocator, entries, size);
     return (strlib_result_t){
         .code = STRLIB_E_NO_MEMORY,
     };
   }
 
+  // borrow the chars of every string, compacting ropes once up front
+  for (size_t i = 0; i < count; i++) {
+    const char *chars = NULL;
+    strlib_result_t res = borrow_chars(strs[i], &chars);
+    if (res.code != STRLIB_E_SUCCESS) {
+      unlock_shared(guards, num_guards);
+      deallocate(&libc_allocator, entries, size);
+      return res;
+    }
+    entries[i] = (strlib_sort_entry_t){
+        .chars = chars,
+        .length = strs[i]->length,
+        .s = strs[i],
+    };
+  }
+
+  sort_radix(entries, entries + count, count, 0);
+  for (size_t i = 0; i < count; i++) {
+    strs[i] = entries[i].s;
+  }
+  unlock_shared(guards, num_guards);
+  deallocate(&libc_allocator, entries, size);
+
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-static strlib_result_t validate_insert_position(const strlib_str_t *s,
-                                                const size_t position) {
-  // error if inserting past length (can insert at end)
-  if (position > s->capacity) {
+strlib_result_t strlib_get_length(const strlib_str_t *s, size_t *length) {
+  STRLIB_PROBE(get_length);
+  assert(s);
+  STRLIB_LOCK(s, false);
+  *length = s->length;
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_get_capacity(const strlib_str_t *s, size_t *capacity) {
+  STRLIB_PROBE(get_capacity);
+  assert(s);
+  STRLIB_LOCK(s, false);
+  *capacity = is_rope(s) ? s->rope->bytes : s->capacity;
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_get_growth_policy(const strlib_str_t *s,
+                                         strlib_growth_policy_t *policy) {
+  STRLIB_PROBE(get_growth_policy);
+  assert(s);
+  STRLIB_LOCK(s, false);
+  *policy = s->growth;
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_set_growth_policy(strlib_str_t *s,
+                                         const strlib_growth_policy_t policy) {
+  STRLIB_PROBE(set_growth_policy);
+  assert(s);
+  STRLIB_LOCK(s, true);
+
+  // error if capped growth could never make progress
+  if (policy.strategy == STRLIB_GROWTH_CAPPED && policy.limit == 0) {
     return (strlib_result_t){
-        .code = STRLIB_E_BAD_INDEX,
+        .code = STRLIB_E_BAD_SIZE,
     };
   }
 
+  s->growth = policy;
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-static strlib_result_t shift_chars_right_by_x_from_position(strlib_str_t *s,
-                                                            size_t x,
-                                                            size_t position) {
-  // move chars to make room for insert
-  for (size_t i = s->length + x; i >= (position + x); i--) {
-    s->chars[i] = s->chars[i - x];
+strlib_result_t strlib_reserve(strlib_str_t *s, const size_t capacity) {
+  STRLIB_PROBE(reserve);
+  assert(s);
+  STRLIB_LOCK(s, true);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
   }
 
-  // update length for additional substr length
-  s->length += x;
+  // reserving never shrinks the string
+  if (capacity <= s->capacity || capacity <= s->length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  return set_capacity(s, capacity);
+}
+
+strlib_result_t strlib_shrink_to_fit(strlib_str_t *s) {
+  STRLIB_PROBE(shrink_to_fit);
+  assert(s);
+  STRLIB_LOCK(s, true);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // keep room for the null terminator, mapped contents use no heap at all
+  if (s->capacity == s->length + 1 || is_small(s) || is_mapped(s)) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  return set_capacity(s, s->length + 1);
+}
+
+strlib_result_t strlib_replace_char(strlib_str_t *s, const char c,
+                                    const size_t position) {
+  STRLIB_PROBE(replace_char);
+  assert(s);
+  STRLIB_MODIFY(s);
+
+  // error if replacing outside of the string
+  if (position >= s->length) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_INDEX,
+    };
+  }
+
+  // ropes insert the new char behind the old one before removing it, so
+  // that a failed insert leaves the string untouched
+  if (s->rope != NULL) {
+    strlib_result_t res = rope_activate(s);
+    if (res.code != STRLIB_E_SUCCESS) {
+      return res;
+    }
+    if (!rope_reserve_nodes(s->rope, s->allocator, 4)) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    res = rope_insert(s, &c, 1, position + 1, false);
+    if (res.code != STRLIB_E_SUCCESS) {
+      return res;
+    }
+    return rope_remove(s, position, 1);
+  }
+
+  // a single char is overwritten in place
+  strlib_result_t res = own_chars(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  s->chars[position] = c;
 
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-static strlib_result_t write_characters_to_position(strlib_str_t *s,
-                                                    const char *cs,
-                                                    const size_t strlen_cs,
-                                                    const size_t position,
-                                                    const bool reversed) {
-  // write cs into position
-  for (size_t i = 0; i < strlen_cs; i++) {
-    s->chars[i + position] = (reversed) ? cs[strlen_cs - i] : cs[i];
+strlib_result_t strlib_replace_slice(strlib_str_t *s, const char *cs,
+                                     const strlib_slice_t slice) {
+  STRLIB_PROBE(replace_slice);
+  STRLIB_MODIFY(s);
+  return replace_slice_n(s, cs, strlen(cs), slice);
+}
+
+strlib_result_t strlib_replace_slice_n(strlib_str_t *s, const char *cs,
+                                       const size_t cs_length,
+                                       const strlib_slice_t slice) {
+  STRLIB_PROBE(replace_slice_n);
+  return replace_slice_n(s, cs, cs_length, slice);
+}
+
+strlib_result_t strlib_replace_slice_view(strlib_str_t *s,
+                                          const strlib_view_t view,
+                                          const strlib_slice_t slice) {
+  STRLIB_PROBE(replace_slice_view);
+  return replace_slice_view(s, view, slice);
+}
+
+strlib_result_t strlib_replace_substr(strlib_str_t *s, const char *substr,
+                                      const char *cs) {
+  STRLIB_PROBE(replace_substr);
+  STRLIB_MODIFY(s);
+  size_t num_replaced = 0;
+  return replace_substr_max_n(s, substr, strlen(substr), cs, strlen(cs),
+                              SIZE_MAX, &num_replaced);
+}
+
+strlib_result_t strlib_replace_substr_n(strlib_str_t *s, const char *substr,
+                                        const size_t substr_length,
+                                        const char *cs,
+                                        const size_t cs_length) {
+  STRLIB_PROBE(replace_substr_n);
+  STRLIB_MODIFY(s);
+  size_t num_replaced = 0;
+  return replace_substr_max_n(s, substr, substr_length, cs, cs_length,
+                              SIZE_MAX, &num_replaced);
+}
+
+strlib_result_t strlib_replace_substr_max(strlib_str_t *s, const char *substr,
+                                          const char *cs,
+                                          const size_t max_replacements,
+                                          size_t *num_replaced) {
+  STRLIB_PROBE(replace_substr_max);
+  STRLIB_MODIFY(s);
+  return replace_substr_max_n(s, substr, strlen(substr), cs, strlen(cs),
+                              max_replacements, num_replaced);
+}
+
+strlib_result_t strlib_replace_substr_max_n(strlib_str_t *s,
+                                            const char *substr,
+                                            const size_t substr_length,
+                                            const char *cs,
+                                            const size_t cs_length,
+                                            const size_t max_replacements,
+                                            size_t *num_replaced) {
+  STRLIB_PROBE(replace_substr_max_n);
+  return replace_substr_max_n(s, substr, substr_length, cs, cs_length,
+                              max_replacements, num_replaced);
+}
+
+strlib_result_t strlib_replace_many(strlib_str_t *s,
+                                    const strlib_view_t *needles,
+                                    const strlib_view_t *replacements,
+                                    const size_t num_pairs) {
+  STRLIB_PROBE(replace_many);
+  assert(s);
+  STRLIB_MODIFY(s);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // the needles are compiled to a trie walked at every candidate index
+  strlib_matcher_t header = {0};
+  strlib_matcher_build_t build;
+  res = matcher_build_begin(&build, &header, needles, num_pairs);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  res = replace_many(s, &build, &header, needles, replacements, num_pairs);
+  matcher_build_end(&build);
+
+  return res;
+}
+
+strlib_result_t strlib_remove_char(strlib_str_t *s, const size_t position) {
+  STRLIB_PROBE(remove_char);
+  STRLIB_MODIFY(s);
+  return remove_slice(
+      s, (strlib_slice_t){.start = position, .end = position});
+}
+
+strlib_result_t strlib_remove_slice(strlib_str_t *s,
+                                    const strlib_slice_t slice) {
+  STRLIB_PROBE(remove_slice);
+  return remove_slice(s, slice);
+}
+
+strlib_result_t strlib_remove_substr(strlib_str_t *s, const char *substr) {
+  STRLIB_PROBE(remove_substr);
+  STRLIB_MODIFY(s);
+  return remove_substr_n(s, substr, strlen(substr));
+}
+
+strlib_result_t strlib_remove_substr_n(strlib_str_t *s, const char *substr,
+                                       const size_t substr_length) {
+  STRLIB_PROBE(remove_substr_n);
+  return remove_substr_n(s, substr, substr_length);
+}
+
+strlib_result_t strlib_remove_slices(strlib_str_t *s,
+                                     const strlib_slice_t *slices,
+                                     const size_t num_slices) {
+  STRLIB_PROBE(remove_slices);
+  assert(s);
+  STRLIB_MODIFY(s);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // error if any slice reaches past the contents, and note whether the
+  // slices already come in ascending order
+  bool ascending = true;
+  for (size_t i = 0; i < num_slices; i++) {
+    if (slices[i].start >= s->length || slices[i].end >= s->length) {
+      return (strlib_result_t){
+          .code = STRLIB_E_BAD_INDEX,
+      };
+    }
+    if (i > 0 && slice_low(slices[i]) < slice_low(slices[i - 1])) {
+      ascending = false;
+    }
+  }
+
+  res = own_chars(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // sort a scratch copy rather than the caller's slices if needed
+  strlib_slice_t *sorted = NULL;
+  if (!ascending) {
+    sorted = (strlib_slice_t *)allocate(&libc_allocator,
+                                        num_slices * sizeof(strlib_slice_t));
+    if (sorted == NULL) {
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    memcpy(sorted, slices, num_slices * sizeof(strlib_slice_t));
+    qsort(sorted, num_slices, sizeof(strlib_slice_t), compare_slices);
+  }
+  const strlib_slice_t *ordered = ascending ? slices : sorted;
+
+  // keep the runs between slices, merging slices which overlap
+  size_t write = 0;
+  size_t read = 0;
+  for (size_t i = 0; i < num_slices; i++) {
+    size_t start = slice_low(ordered[i]);
+    size_t end = slice_high(ordered[i]) + 1;
+    if (end <= read) {
+      continue;
+    }
+    if (start > read) {
+      move_bytes(s->chars + write, s->chars + read, start - read);
+      write += start - read;
+    }
+    read = end;
   }
+  finish_compaction(s, write, read);
 
+  if (sorted != NULL) {
+    deallocate(&libc_allocator, sorted, num_slices * sizeof(strlib_slice_t));
+  }
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-static strlib_result_t validate_can_store_position(
-    const size_t num_positions, const size_t positions_size) {
-  // raise an error if we are going out of bounds on our positions array
-  if (num_positions >= positions_size) {
+strlib_result_t strlib_remove_any_char(strlib_str_t *s, const char *set) {
+  STRLIB_PROBE(remove_any_char);
+  STRLIB_MODIFY(s);
+  return remove_any_char_n(s, set, strlen(set));
+}
+
+strlib_result_t strlib_remove_any_char_n(strlib_str_t *s, const char *set,
+                                         const size_t set_length) {
+  STRLIB_PROBE(remove_any_char_n);
+  return remove_any_char_n(s, set, set_length);
+}
+
+strlib_result_t strlib_edits_init(strlib_edits_t **edits) {
+  STRLIB_PROBE(edits_init);
+  assert(edits);
+  (*edits) =
+      (strlib_edits_t *)allocate(&libc_allocator, sizeof(strlib_edits_t));
+  if ((*edits) == NULL) {
     return (strlib_result_t){
-        .code = STRLIB_E_BAD_SIZE,
+        .code = STRLIB_E_NO_MEMORY,
     };
   }
+  *(*edits) = (strlib_edits_t){0};
 
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-static strlib_result_t validate_str_slice(const strlib_str_t *s,
-                                          const strlib_slice_t slice) {
-  // error if trying to get position outside of string
-  if (slice.start > s->length || slice.end > s->length) {
+strlib_result_t strlib_edits_insert(strlib_edits_t *edits,
+                                    const size_t position,
+                                    const strlib_view_t view) {
+  STRLIB_PROBE(edits_insert);
+  assert(edits);
+  return edits_add(edits,
+                   (strlib_edit_t){
+                       .start = position,
+                       .end = position,
+                       .insert = true,
+                   },
+                   view);
+}
+
+strlib_result_t strlib_edits_remove(strlib_edits_t *edits,
+                                    const strlib_slice_t slice) {
+  STRLIB_PROBE(edits_remove);
+  assert(edits);
+  return edits_add(edits,
+                   (strlib_edit_t){
+                       .start = slice_low(slice),
+                       .end = slice_high(slice),
+                   },
+                   (strlib_view_t){0});
+}
+
+strlib_result_t strlib_edits_replace(strlib_edits_t *edits,
+                                     const strlib_slice_t slice,
+                                     const strlib_view_t view) {
+  STRLIB_PROBE(edits_replace);
+  assert(edits);
+  return edits_add(edits,
+                   (strlib_edit_t){
+                       .start = slice_low(slice),
+                       .end = slice_high(slice),
+                       .reversed = slice.start > slice.end,
+                   },
+                   view);
+}
+
+strlib_result_t strlib_apply_edits(strlib_str_t *s, strlib_edits_t *edits) {
+  STRLIB_PROBE(apply_edits);
+  assert(s);
+  assert(edits);
+  STRLIB_MODIFY(s);
+  strlib_result_t res = flatten(s);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+
+  // edits are usually added front to back, in which case there is nothing
+  // to sort
+  for (size_t i = 1; i < edits->num_edits; i++) {
+    if (compare_edits(&edits->edits[i - 1], &edits->edits[i]) > 0) {
+      qsort(edits->edits, edits->num_edits, sizeof(strlib_edit_t),
+            compare_edits);
+      break;
+    }
+  }
+
+  size_t new_length;
+  res = edits_validate(edits, s->length, &new_length);
+  if (res.code != STRLIB_E_SUCCESS || edits->num_edits == 0) {
+    return res;
+  }
+
+  // the kept runs are read from the old chars while the new ones are
+  // written, then the old chars are released
+  char small[STRLIB_SMALL_CAPACITY];
+  size_t capacity;
+  char *chars = rewrite_begin(s, new_length, small, &capacity);
+  if (chars == NULL) {
     return (strlib_result_t){
-        .code = STRLIB_E_BAD_INDEX,
+        .code = STRLIB_E_NO_MEMORY,
     };
   }
+  edits_write(edits, (strlib_view_t){.chars = s->chars, .length = s->length},
+              chars);
+  rewrite_finish(s, chars, small, capacity, new_length);
 
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-static strlib_result_t get_slice_length_and_capacity(const strlib_slice_t slice,
-                                                     size_t *length,
-                                                     size_t *capacity) {
-  // error if buffer is not large enough to hold slice
-  size_t req_length = slice.end > slice.start ? (slice.end - slice.start) + 1
-                                              : (slice.start - slice.end) + 1;
-  *length = req_length;
-  *capacity = req_length + 1;
+strlib_result_t strlib_edits_reset(strlib_edits_t *edits) {
+  STRLIB_PROBE(edits_reset);
+  assert(edits);
+  edits->num_edits = 0;
+  edits->num_chars = 0;
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-static strlib_result_t validate_buffer_can_hold_slice(const size_t buf_size,
-                                                      const size_t slice_size) {
-  // error if buffer is not large enough to hold slice
-  if (buf_size < slice_size) {
+strlib_result_t strlib_edits_free(strlib_edits_t *edits) {
+  STRLIB_PROBE(edits_free);
+  assert(edits);
+  if (edits->edits != NULL) {
+    deallocate(&libc_allocator, edits->edits,
+               edits->edits_capacity * sizeof(strlib_edit_t));
+  }
+  if (edits->chars != NULL) {
+    deallocate(&libc_allocator, edits->chars, edits->chars_capacity);
+  }
+  deallocate(&libc_allocator, edits, sizeof(strlib_edits_t));
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_set(strlib_str_t *s, const char *buf,
+                           const size_t size) {
+  STRLIB_PROBE(set);
+  assert(s);
+  STRLIB_MODIFY(s);
+
+  // `size` counts the null terminator, which is written rather than copied
+  return set_chars(s, buf, (size == 0) ? 0 : size - 1);
+}
+
+strlib_result_t strlib_set_n(strlib_str_t *s, const char *chars,
+                             const size_t length) {
+  STRLIB_PROBE(set_n);
+  assert(s);
+  STRLIB_MODIFY(s);
+  return set_chars(s, chars, length);
+}
+
+strlib_result_t strlib_clear(strlib_str_t *s) {
+  STRLIB_PROBE(clear);
+  assert(s);
+  STRLIB_MODIFY(s);
+
+  // capacity is kept for the next contents
+  if (is_rope(s)) {
+    rope_clear(s->rope, s->allocator);
+    s->rope->active = false;
+  }
+  drop_mapping(s);
+  s->length = 0;
+  s->chars[0] = '\0';
+
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
+
+strlib_result_t strlib_assign_from(strlib_str_t *s, const strlib_str_t *src) {
+  STRLIB_PROBE(assign_from);
+  assert(s);
+  assert(src);
+  STRLIB_LOCK_PAIR(s, true, src, false);
+  forget_hash(s);
+  if (s == src) {
     return (strlib_result_t){
-        .code = STRLIB_E_BAD_SIZE,
+        .code = STRLIB_E_SUCCESS,
+    };
+  }
+
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(src, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  return set_chars(s, chars, src->length);
+}
+
+strlib_result_t strlib_append(strlib_str_t *s, const strlib_view_t view) {
+  STRLIB_PROBE(append);
+  assert(s);
+  STRLIB_MODIFY(s);
+  return append_views(s, &view, 1,
+                      (strlib_view_t){.chars = NULL, .length = 0});
+}
+
+strlib_result_t strlib_append_str(strlib_str_t *s, const strlib_str_t *src) {
+  STRLIB_PROBE(append_str);
+  assert(s);
+  assert(src);
+  STRLIB_LOCK_PAIR(s, true, src, false);
+  forget_hash(s);
+  size_t length = src->length;
+  if (length == 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
     };
   }
 
-  return (strlib_result_t){
-      .code = STRLIB_E_SUCCESS,
-  };
+  // the chars are borrowed after growing, so that a string appended to
+  // itself is copied from where its contents moved
+  strlib_result_t res = append_reserve(s, length);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  const char *chars = NULL;
+  res = borrow_chars(src, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
+  }
+  return append_piece(s, chars, length);
+}
+
+strlib_result_t strlib_concat(strlib_str_t *s, const strlib_view_t *parts,
+                              const size_t num_parts) {
+  STRLIB_PROBE(concat);
+  assert(s);
+  assert(parts || num_parts == 0);
+  STRLIB_MODIFY(s);
+  return append_views(s, parts, num_parts,
+                      (strlib_view_t){.chars = NULL, .length = 0});
 }
 
-static strlib_result_t read_characters_from_position(const strlib_str_t *s,
-                                                     char *buf,
-                                                     const size_t num_to_read,
-                                                     const size_t position,
-                                                     const bool reversed) {
-  // copy the slice from start to finish
-  size_t idx = position;
+strlib_result_t strlib_concat_cstrs(strlib_str_t *s, ...) {
+  STRLIB_PROBE(concat_cstrs);
+  assert(s);
+  STRLIB_MODIFY(s);
+  va_list args;
 
-  for (size_t i = 0; i < num_to_read; i++) {
-    // copy into buffer, update index depending on slice direction
-    buf[i] = (*s).chars[idx];
-    idx = reversed ? idx - 1 : idx + 1;
+  // the arguments are walked twice, once to size the contents and once to
+  // copy them
+  size_t total = 0;
+  va_start(args, s);
+  for (const char *cs = va_arg(args, const char *); cs != NULL;
+       cs = va_arg(args, const char *)) {
+    size_t length = strlen(cs);
+    if (length > SIZE_MAX - total) {
+      va_end(args);
+      return (strlib_result_t){
+          .code = STRLIB_E_NO_MEMORY,
+      };
+    }
+    total += length;
   }
-  // write null terminator
-  buf[num_to_read] = '\0';
-
-  return (strlib_result_t){
-      .code = STRLIB_E_SUCCESS,
-  };
-}
-
-static strlib_result_t copy_chars_x_over_left_starting_at_position(
-    strlib_str_t *s, const size_t x, const size_t position) {
-  // copy all trailing characters from position forward
-  for (size_t i = position; i <= (s->length - x); i++) {
-    s->chars[i] = s->chars[i + x];
+  va_end(args);
+  if (total == 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
   }
 
-  // replace end characters with null terminator and bump length
-  for (size_t i = s->length - x + 1; i <= s->length; i++) s->chars[i] = '\0';
-  s->length = s->length - x;
+  strlib_result_t res = append_reserve(s, total);
+  va_start(args, s);
+  for (const char *cs = va_arg(args, const char *);
+       cs != NULL && res.code == STRLIB_E_SUCCESS;
+       cs = va_arg(args, const char *)) {
+    res = append_piece(s, cs, strlen(cs));
+  }
+  va_end(args);
 
-  return (strlib_result_t){
-      .code = STRLIB_E_SUCCESS,
-  };
+  return res;
 }
 
-/*******************************************************************************/
+strlib_result_t strlib_join(strlib_str_t *s, const strlib_view_t separator,
+                            const strlib_view_t *parts,
+                            const size_t num_parts) {
+  STRLIB_PROBE(join);
+  assert(s);
+  assert(parts || num_parts == 0);
+  STRLIB_MODIFY(s);
+  return append_views(s, parts, num_parts, separator);
+}
 
-/*
-** Functions which are provided by strlib to be used by external callers.
-*/
+strlib_result_t strlib_free(strlib_str_t *s) {
+  STRLIB_PROBE(free);
+  return free_str(s);
+}
 
-strlib_result_t strlib_init(strlib_str_t **s) {
-  // create space for opaque pointer
-  (*s) = (strlib_str_t *)calloc(1, sizeof(strlib_str_t));
+strlib_result_t strlib_stream_init(strlib_stream_t **stream,
+                                   const strlib_view_t pattern,
+                                   strlib_match_callback_t callback,
+                                   void *ctx) {
+  STRLIB_PROBE(stream_init);
+  assert(callback);
 
-  // error if space for opaque pointer cannot be allocated
-  if ((*s) == NULL) {
+  // room for the pattern, the carried chars and the joined boundary, which
+  // is twice the size of the carried chars
+  size_t carry_size = (pattern.length == 0) ? 0 : pattern.length - 1;
+  if (pattern.length > (SIZE_MAX - sizeof(strlib_stream_t)) / 4) {
     return (strlib_result_t){
         .code = STRLIB_E_NO_MEMORY,
     };
   }
-
-  // initialize components
-  (*s)->length = 0;
-  (*s)->capacity = 256;
-  (*s)->chars = (char *)calloc(1, sizeof(char[256]));
-
-  // error if space for char array isn't allocated
-  if ((*s)->chars == NULL) {
+  size_t size = sizeof(strlib_stream_t) + pattern.length + (3 * carry_size);
+  (*stream) = (strlib_stream_t *)allocate(&libc_allocator, size);
+  if ((*stream) == NULL) {
     return (strlib_result_t){
         .code = STRLIB_E_NO_MEMORY,
     };
   }
 
+  char *chars = (char *)(*stream) + sizeof(strlib_stream_t);
+  if (pattern.length != 0) {
+    copy_bytes(chars, pattern.chars, pattern.length);
+  }
+  *(*stream) = (strlib_stream_t){
+      .callback = callback,
+      .ctx = ctx,
+      .offset = 0,
+      .carried = 0,
+      .carry = chars + pattern.length,
+      .scratch = chars + pattern.length + carry_size,
+      .size = size,
+  };
+  search_init(&(*stream)->search, chars, pattern.length);
+
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_find_char(strlib_str_t *s, size_t *positions,
-                                 size_t *num_positions,
-                                 const size_t positions_size, const char c) {
-  strlib_slice_t *slices = calloc(positions_size, sizeof(strlib_slice_t));
-  char substr[2] = {0};
-  substr[0] = c;
+strlib_result_t strlib_stream_feed(strlib_stream_t *stream, const char *chunk,
+                                   const size_t length) {
+  STRLIB_PROBE(stream_feed);
+  assert(stream);
+  const strlib_search_t *search = &stream->search;
+  size_t carry_size = (search->length == 0) ? 0 : search->length - 1;
 
-  strlib_result_t res =
-      strlib_find_substr(s, slices, num_positions, positions_size, substr);
-  if (res.code != STRLIB_E_SUCCESS) {
-    free(slices);
-    return res;
+  // matches starting in the carried chars end within the first
+  // `carry_size` chars of the chunk
+  if (stream->carried > 0 && length > 0) {
+    size_t head = (length < carry_size) ? length : carry_size;
+    size_t joined = stream->carried + head;
+    size_t base = stream->offset - stream->carried;
+    copy_bytes(stream->scratch, stream->carry, stream->carried);
+    copy_bytes(stream->scratch + stream->carried, chunk, head);
+    size_t pos = search_next(search, stream->scratch, joined, 0);
+    while (pos != STRLIB_NOT_FOUND && pos < stream->carried) {
+      stream->callback(stream->ctx,
+                       (strlib_slice_t){
+                           .start = base + pos,
+                           .end = base + pos + (search->length - 1),
+                       });
+      pos = search_next(search, stream->scratch, joined, pos + 1);
+    }
   }
 
-  for (size_t i = 0; i <= *num_positions; i++) {
-    positions[i] = slices[i].start;
+  // then those within the chunk
+  size_t pos = search_next(search, chunk, length, 0);
+  while (pos != STRLIB_NOT_FOUND) {
+    stream->callback(stream->ctx,
+                     (strlib_slice_t){
+                         .start = stream->offset + pos,
+                         .end = stream->offset + pos + (search->length - 1),
+                     });
+    pos = search_next(search, chunk, length, pos + 1);
   }
 
-  free(slices);
+  // carry the last chars fed over to the next chunk
+  if (length >= carry_size) {
+    if (carry_size != 0) {
+      copy_bytes(stream->carry, chunk + (length - carry_size), carry_size);
+    }
+    stream->carried = carry_size;
+  } else if (length > 0) {
+    size_t kept = carry_size - length;
+    if (kept > stream->carried) kept = stream->carried;
+    move_bytes(stream->carry, stream->carry + (stream->carried - kept), kept);
+    copy_bytes(stream->carry + kept, chunk, length);
+    stream->carried = kept + length;
+  }
+  stream->offset += length;
+
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_find_substr(strlib_str_t *s, strlib_slice_t *slices,
-                                   size_t *num_positions,
-                                   const size_t positions_size,
-                                   const char *substr) {
-  // initialize substring finding
-  char *substr_head = NULL;
-  *num_positions = 0;
-  substr_head = strstr(s->chars, substr);
-
-  // while there are more substrings
-  while (substr_head != NULL) {
-    strlib_result_t res =
-        validate_can_store_position(*num_positions, positions_size);
-    if (res.code != STRLIB_E_SUCCESS) {
-      return res;
-    }
-
-    // add found position to positions array and increment positions counter
-    slices[(*num_positions)++] = (strlib_slice_t){
-        .start = (size_t)(substr_head - s->chars),
-        .end = (size_t)(substr_head - s->chars) + (strlen(substr) - 1)};
-
-    // attempt to find next substring by incrementing one past current
-    // substring
-    substr_head = strstr(substr_head + 1, substr);
-  }
-
+strlib_result_t strlib_stream_reset(strlib_stream_t *stream) {
+  STRLIB_PROBE(stream_reset);
+  assert(stream);
+  stream->offset = 0;
+  stream->carried = 0;
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_insert_char(strlib_str_t *s, const char c,
-                                   const size_t position) {
-  return strlib_insert_chars(s, &c, 1, position, false);
+strlib_result_t strlib_stream_free(strlib_stream_t *stream) {
+  STRLIB_PROBE(stream_free);
+  assert(stream);
+  deallocate(&libc_allocator, stream, stream->size);
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
 }
 
-strlib_result_t strlib_insert_chars(strlib_str_t *s, const char *cs,
-                                    const size_t len_cs, const size_t position,
-                                    const bool reversed) {
-  assert(s);
+strlib_result_t strlib_matcher_init(strlib_matcher_t **matcher,
+                                    const strlib_view_t *patterns,
+                                    const size_t num_patterns) {
+  STRLIB_PROBE(matcher_init);
+  assert(matcher);
 
-  strlib_result_t res = validate_insert_position(s, position);
+  // compile in scratch first, as the size of the matcher depends on how
+  // many prefixes the patterns share
+  strlib_matcher_t header = {0};
+  strlib_matcher_build_t build;
+  strlib_result_t res =
+      matcher_build_begin(&build, &header, patterns, num_patterns);
   if (res.code != STRLIB_E_SUCCESS) {
     return res;
   }
+  matcher_build_links(&build, header.num_classes);
+  header.num_states = build.num_states;
+  header.first_output = matcher_number_states(&build);
 
-  res = resize_chars(s, len_cs);
-  if (res.code != STRLIB_E_SUCCESS) {
-    return res;
+  // the lengths, rows, outputs and ids follow the header
+  size_t num_ids = 0;
+  for (size_t i = 0; i < num_patterns; i++) {
+    num_ids += (patterns[i].length != 0) ? 1 : 0;
   }
-
-  res = shift_chars_right_by_x_from_position(s, len_cs, position);
-  if (res.code != STRLIB_E_SUCCESS) {
-    return res;
+  size_t num_outputs = header.num_states - header.first_output;
+  size_t num_edges = header.num_states * header.num_classes;
+  header.size = sizeof(strlib_matcher_t) + (num_patterns * sizeof(size_t)) +
+                (num_edges * sizeof(uint32_t)) +
+                (num_outputs * sizeof(strlib_matcher_output_t)) +
+                (num_ids * sizeof(uint32_t));
+  (*matcher) = (strlib_matcher_t *)allocate(&libc_allocator, header.size);
+  if ((*matcher) != NULL) {
+    header.lengths = (size_t *)((*matcher) + 1);
+    header.next = (uint32_t *)(header.lengths + num_patterns);
+    header.outputs = (strlib_matcher_output_t *)(header.next + num_edges);
+    header.ids = (uint32_t *)(header.outputs + num_outputs);
+    *(*matcher) = header;
+    for (size_t i = 0; i < num_patterns; i++) {
+      (*matcher)->lengths[i] = patterns[i].length;
+    }
+    matcher_fill(*matcher, &build);
   }
-
-  res = write_characters_to_position(s, cs, len_cs, position, reversed);
-  if (res.code != STRLIB_E_SUCCESS) {
-    return res;
+  matcher_build_end(&build);
+  if ((*matcher) == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
   }
 
   return (strlib_result_t){
@@ -306,254 +5092,331 @@ strlib_result_t strlib_insert_chars(strlib_str_t *s, const char *cs,
   };
 }
 
-strlib_result_t strlib_get(const strlib_str_t *s, char *buf,
-                           const size_t size) {
-  return strlib_get_slice(s, buf, size,
-                          (strlib_slice_t){.start = 0, .end = s->length});
-}
-
-strlib_result_t strlib_get_char(const strlib_str_t *s, char *c,
-                                const size_t position) {
-  // I need a null terminator for uniformity
-  char cs[2] = {0};
-
-  strlib_result_t res = strlib_get_slice(
-      s, cs, 2, (strlib_slice_t){.start = position, .end = position});
+strlib_result_t strlib_matcher_find(const strlib_matcher_t *matcher,
+                                    strlib_str_t *s, strlib_match_t *matches,
+                                    size_t *num_matches,
+                                    const size_t matches_size) {
+  STRLIB_PROBE(matcher_find);
+  assert(matcher);
+  assert(s);
+  STRLIB_LOCK(s, false);
+  strlib_result_t res = flatten(s);
   if (res.code != STRLIB_E_SUCCESS) {
     return res;
   }
-  *c = cs[0];
-  return res;
+
+  return matcher_scan(matcher, s->chars, s->length, matches, num_matches,
+                      matches_size);
 }
 
-strlib_result_t strlib_get_slice(const strlib_str_t *s, char *buf,
-                                 const size_t size,
-                                 const strlib_slice_t slice) {
-  assert(s);
-  size_t slice_length = 0;
-  size_t slice_capacity = 0;
+strlib_result_t strlib_matcher_find_view(const strlib_matcher_t *matcher,
+                                         const strlib_view_t text,
+                                         strlib_match_t *matches,
+                                         size_t *num_matches,
+                                         const size_t matches_size) {
+  STRLIB_PROBE(matcher_find_view);
+  assert(matcher);
+  return matcher_scan(matcher, text.chars, text.length, matches, num_matches,
+                      matches_size);
+}
 
-  strlib_result_t res =
-      get_slice_length_and_capacity(slice, &slice_length, &slice_capacity);
-  if (res.code != STRLIB_E_SUCCESS) {
-    return res;
-  }
+strlib_result_t strlib_matcher_free(strlib_matcher_t *matcher) {
+  STRLIB_PROBE(matcher_free);
+  assert(matcher);
+  deallocate(&libc_allocator, matcher, matcher->size);
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
 
-  res = validate_str_slice(s, slice);
-  if (res.code != STRLIB_E_SUCCESS) {
-    return res;
-  }
+strlib_result_t strlib_hash(const strlib_str_t *s, uint64_t *hash) {
+  STRLIB_PROBE(hash);
+  assert(s);
+  assert(hash);
+  STRLIB_LOCK(s, false);
 
-  res = validate_buffer_can_hold_slice(size, slice_capacity);
-  if (res.code != STRLIB_E_SUCCESS) {
-    return res;
+  // the cache is written through a const string, as filling it does not
+  // change the contents; racing readers all store the same value
+  strlib_str_t *cache = (strlib_str_t *)(uintptr_t)s;
+  *hash = atomic_load_explicit(&cache->hash, memory_order_relaxed);
+  if (*hash != 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_SUCCESS,
+    };
   }
-
-  res = read_characters_from_position(s, buf, slice_length, slice.start,
-                                      (slice.start > slice.end));
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(s, &chars);
   if (res.code != STRLIB_E_SUCCESS) {
     return res;
   }
+  *hash = hash_bytes(chars, s->length);
+  atomic_store_explicit(&cache->hash, *hash, memory_order_relaxed);
 
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_get_length(const strlib_str_t *s, size_t *length) {
-  assert(s);
-  *length = s->length;
+strlib_result_t strlib_hash_view(const strlib_view_t view, uint64_t *hash) {
+  STRLIB_PROBE(hash_view);
+  assert(hash);
+  assert(view.chars != NULL || view.length == 0);
+  *hash = hash_bytes(view.chars, view.length);
+
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_get_capacity(const strlib_str_t *s, size_t *capacity) {
-  assert(s);
-  *capacity = s->capacity;
+strlib_result_t strlib_intern_init(strlib_intern_t **table) {
+  STRLIB_PROBE(intern_init);
+  assert(table);
+  (*table) =
+      (strlib_intern_t *)allocate(&libc_allocator, sizeof(strlib_intern_t));
+  if ((*table) == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
+  }
+  *(*table) = (strlib_intern_t){0};
+
+  // shards are set up one by one, and those done are undone on failure
+  for (size_t i = 0; i < STRLIB_INTERN_SHARDS; i++) {
+    strlib_intern_shard_t *shard = &(*table)->shards[i];
+    strlib_result_t res =
+        arena_init(&shard->arena, STRLIB_INTERN_BLOCK_SIZE);
+    if (res.code == STRLIB_E_SUCCESS &&
+        pthread_rwlock_init(&shard->lock, NULL) != 0) {
+      arena_free(shard->arena);
+      res.code = STRLIB_E_NO_MEMORY;
+    }
+    if (res.code != STRLIB_E_SUCCESS) {
+      while (i-- > 0) {
+        (void)pthread_rwlock_destroy(&(*table)->shards[i].lock);
+        arena_free((*table)->shards[i].arena);
+      }
+      deallocate(&libc_allocator, *table, sizeof(strlib_intern_t));
+      return res;
+    }
+  }
+
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_replace_char(strlib_str_t *s, const char c,
-                                    const size_t position) {
-  return strlib_replace_slice(
-      s, &c, (strlib_slice_t){.start = position, .end = position});
+strlib_result_t strlib_intern(strlib_intern_t *table, const strlib_view_t view,
+                              const strlib_str_t **interned) {
+  STRLIB_PROBE(intern);
+  return intern_view(table, view, interned);
 }
 
-strlib_result_t strlib_replace_slice(strlib_str_t *s, const char *cs,
-                                     const strlib_slice_t slice) {
+strlib_result_t strlib_intern_str(strlib_intern_t *table,
+                                  const strlib_str_t *s,
+                                  const strlib_str_t **interned) {
+  STRLIB_PROBE(intern_str);
   assert(s);
-
-  strlib_result_t result = strlib_remove_slice(s, slice);
-  if (result.code != STRLIB_E_SUCCESS) {
-    return result;
+  STRLIB_LOCK(s, false);
+  const char *chars = NULL;
+  strlib_result_t res = borrow_chars(s, &chars);
+  if (res.code != STRLIB_E_SUCCESS) {
+    return res;
   }
+  return intern_view(
+      table, (strlib_view_t){.chars = chars, .length = s->length}, interned);
+}
 
-  result = strlib_insert_chars(
-      s, cs, strlen(cs), (slice.start > slice.end) ? slice.end : slice.start,
-      (slice.start > slice.end));
-  if (result.code != STRLIB_E_SUCCESS) {
-    return result;
+strlib_result_t strlib_intern_free(strlib_intern_t *table) {
+  STRLIB_PROBE(intern_free);
+  assert(table);
+
+  // the strings go with the arenas they were allocated from
+  for (size_t i = 0; i < STRLIB_INTERN_SHARDS; i++) {
+    strlib_intern_shard_t *shard = &table->shards[i];
+    if (shard->slots != NULL) {
+      deallocate(&libc_allocator, shard->slots,
+                 shard->capacity * sizeof(strlib_intern_slot_t));
+    }
+    (void)pthread_rwlock_destroy(&shard->lock);
+    arena_free(shard->arena);
   }
+  deallocate(&libc_allocator, table, sizeof(strlib_intern_t));
 
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_replace_substr(strlib_str_t *s, const char *substr,
-                                      const char *cs) {
-  assert(s);
-  size_t num_positions = 0;
-  strlib_slice_t *slices = calloc(256, sizeof(strlib_slice_t));
-  size_t len_substr = strlen(substr);
-  size_t len_cs = strlen(cs);
-  size_t offset =
-      (len_substr <= len_cs) ? len_cs - len_substr : len_substr - len_cs;
-
-  strlib_result_t result =
-      strlib_find_substr(s, &slices[0], &num_positions, 256, substr);
-
-  if (result.code != STRLIB_E_SUCCESS) {
-    free(slices);
-    return result;
-  }
-
-  while (num_positions != 0) {
-    for (size_t i = 0; i <= num_positions - 1; i++) {
-      // position shifts for existing removed characters
-      size_t start = (len_substr <= len_cs) ? (slices[i].start) + (offset * i)
-                                            : (slices[i].start) - (offset * i);
-      size_t end = (len_substr <= len_cs) ? (slices[i].end) + (offset * i)
-                                          : (slices[i].end) - (offset * i);
+strlib_result_t strlib_arena_init(strlib_arena_t **arena,
+                                  const size_t block_size) {
+  STRLIB_PROBE(arena_init);
+  return arena_init(arena, block_size);
+}
 
-      result = strlib_replace_slice(
-          s, cs, (strlib_slice_t){.start = start, .end = end});
+strlib_result_t strlib_arena_get_allocator(
+    strlib_arena_t *arena, const strlib_allocator_t **allocator) {
+  STRLIB_PROBE(arena_get_allocator);
+  return arena_get_allocator(arena, allocator);
+}
 
-      if (result.code != STRLIB_E_SUCCESS) {
-        free(slices);
-        return result;
-      }
-    }
+strlib_result_t strlib_arena_reset(strlib_arena_t *arena) {
+  STRLIB_PROBE(arena_reset);
+  assert(arena);
 
-    result = strlib_find_substr(s, &slices[0], &num_positions, 256, substr);
-    if (result.code != STRLIB_E_SUCCESS) {
-      free(slices);
-      return result;
-    }
+  // empty every block and start bumping from the first one again
+  for (strlib_arena_block_t *block = arena->blocks; block != NULL;
+       block = block->next) {
+    block->used = 0;
   }
+  arena->current = arena->blocks;
+  arena->last = NULL;
 
-  free(slices);
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_remove_char(strlib_str_t *s, const size_t position) {
-  return strlib_remove_slice(
-      s, (strlib_slice_t){.start = position, .end = position});
+strlib_result_t strlib_arena_free(strlib_arena_t *arena) {
+  STRLIB_PROBE(arena_free);
+  return arena_free(arena);
 }
 
-strlib_result_t strlib_remove_slice(strlib_str_t *s,
-                                    const strlib_slice_t slice) {
-  assert(s);
-
-  strlib_result_t res = validate_str_slice(s, slice);
-  if (res.code != STRLIB_E_SUCCESS) {
-    return res;
+strlib_result_t strlib_pool_init(strlib_pool_t **pool, const size_t object_size,
+                                 const size_t objects_per_chunk) {
+  STRLIB_PROBE(pool_init);
+  // error if the pool could never hand out memory
+  if (object_size == 0 || objects_per_chunk == 0) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_SIZE,
+    };
   }
 
-  size_t start = (slice.start < slice.end) ? slice.start : slice.end;
-  size_t end = (slice.start < slice.end) ? slice.end : slice.start;
-  size_t size = (end - start) + 1;
+  // objects are aligned and large enough to link the free list through
+  size_t aligned = align_up(object_size);
+  size_t header = align_up(sizeof(strlib_pool_chunk_t));
+  if (aligned == 0 || objects_per_chunk > (SIZE_MAX - header) / aligned) {
+    return (strlib_result_t){
+        .code = STRLIB_E_BAD_SIZE,
+    };
+  }
 
-  res = copy_chars_x_over_left_starting_at_position(s, size, start);
-  if (res.code != STRLIB_E_SUCCESS) {
-    return res;
+  (*pool) = (strlib_pool_t *)calloc(1, sizeof(strlib_pool_t));
+  if ((*pool) == NULL) {
+    return (strlib_result_t){
+        .code = STRLIB_E_NO_MEMORY,
+    };
   }
 
+  (*pool)->allocator = (strlib_allocator_t){
+      .alloc = pool_alloc,
+      .resize = pool_resize,
+      .release = pool_release,
+      .ctx = (*pool),
+  };
+  (*pool)->object_size = aligned;
+  (*pool)->objects_per_chunk = objects_per_chunk;
+
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_remove_substr(strlib_str_t *s, const char *substr) {
-  assert(s);
-  size_t num_positions = 0;
-  strlib_slice_t *slices = calloc(256, sizeof(strlib_slice_t));
+strlib_result_t strlib_pool_get_allocator(
+    strlib_pool_t *pool, const strlib_allocator_t **allocator) {
+  STRLIB_PROBE(pool_get_allocator);
+  assert(pool);
+  *allocator = &pool->allocator;
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
 
-  strlib_result_t result =
-      strlib_find_substr(s, &slices[0], &num_positions, 256, substr);
-  if (result.code != STRLIB_E_SUCCESS) {
-    free(slices);
-    return result;
+strlib_result_t strlib_pool_reset(strlib_pool_t *pool) {
+  STRLIB_PROBE(pool_reset);
+  assert(pool);
+
+  // rebuild the free list from every chunk
+  pool->free_list = NULL;
+  for (strlib_pool_chunk_t *chunk = pool->chunks; chunk != NULL;
+       chunk = chunk->next) {
+    pool_push_chunk(pool, chunk);
   }
 
-  while (num_positions != 0) {
-    for (size_t i = 0; i <= num_positions - 1; i++) {
-      // position shifts for existing removed characters
-      size_t start = (slices[i].start) - (strlen(substr) * i);
-      size_t end = (slices[i].end) - (strlen(substr) * i);
+  return (strlib_result_t){
+      .code = STRLIB_E_SUCCESS,
+  };
+}
 
-      result =
-          strlib_remove_slice(s, (strlib_slice_t){.start = start, .end = end});
-      if (result.code != STRLIB_E_SUCCESS) {
-        free(slices);
-        return result;
-      }
-    }
+strlib_result_t strlib_pool_free(strlib_pool_t *pool) {
+  STRLIB_PROBE(pool_free);
+  assert(pool);
 
-    result = strlib_find_substr(s, &slices[0], &num_positions, 256, substr);
-    if (result.code != STRLIB_E_SUCCESS) {
-      free(slices);
-      return result;
-    }
+  strlib_pool_chunk_t *chunk = pool->chunks;
+  while (chunk != NULL) {
+    strlib_pool_chunk_t *next = chunk->next;
+    free(chunk);
+    chunk = next;
   }
+  free(pool);
 
-  free(slices);
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_set(strlib_str_t *s, const char *buf,
-                           const size_t size) {
-  assert(s);
+strlib_result_t strlib_get_stats(strlib_stats_t *stats) {
+  assert(stats);
+  *stats = (strlib_stats_t){0};
 
-  // set existing characters to null
-  memset(s->chars, '\0', (s->capacity) * sizeof(char));
+#ifdef STRLIB_INSTRUMENT
+  static const char *const names[] = {
+#define STRLIB_OPERATION_NAME(name) "strlib_" #name,
+      STRLIB_OPERATIONS(STRLIB_OPERATION_NAME)
+#undef STRLIB_OPERATION_NAME
+  };
+  _Static_assert(STRLIB_NUM_OPERATIONS <= STRLIB_STATS_MAX_OPERATIONS,
+                 "stats snapshots must fit every operation");
 
-  // allocate more capacity if needed
-  if (size > s->capacity) {
-    s->capacity = size;
-    s->chars = (char *)realloc(s->chars, s->capacity);
-    // error if space for char array isn't allocated
-    if (s->chars == NULL)
-      return (strlib_result_t){
-          .code = STRLIB_E_NO_MEMORY,
-      };
+  // counters are read one by one, so a snapshot taken while other threads
+  // call into strlib is not atomic as a whole
+  stats->enabled = true;
+  stats->allocations =
+      atomic_load_explicit(&counters.allocations, memory_order_relaxed);
+  stats->reallocations =
+      atomic_load_explicit(&counters.reallocations, memory_order_relaxed);
+  stats->releases =
+      atomic_load_explicit(&counters.releases, memory_order_relaxed);
+  stats->bytes_copied =
+      atomic_load_explicit(&counters.bytes_copied, memory_order_relaxed);
+  stats->bytes_moved =
+      atomic_load_explicit(&counters.bytes_moved, memory_order_relaxed);
+  stats->num_operations = STRLIB_NUM_OPERATIONS;
+  for (size_t i = 0; i < STRLIB_NUM_OPERATIONS; i++) {
+    stats->operations[i] = (strlib_operation_stats_t){
+        .name = names[i],
+        .calls = atomic_load_explicit(&counters.calls[i], memory_order_relaxed),
+        .total_ns = atomic_load_explicit(&counters.ns[i], memory_order_relaxed),
+    };
   }
-
-  // copy buffer into chars and set length excluding null terminator
-  strncpy(s->chars, buf, s->capacity);
-  s->length = size - 1;
+#endif
 
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
   };
 }
 
-strlib_result_t strlib_free(strlib_str_t *s) {
-  assert(s);
-
-  // free internal chars
-  free(s->chars);
-  // free structure
-  free(s);
-  // undangle pointer
-  s = NULL;
+strlib_result_t strlib_reset_stats(void) {
+#ifdef STRLIB_INSTRUMENT
+  atomic_store_explicit(&counters.allocations, 0, memory_order_relaxed);
+  atomic_store_explicit(&counters.reallocations, 0, memory_order_relaxed);
+  atomic_store_explicit(&counters.releases, 0, memory_order_relaxed);
+  atomic_store_explicit(&counters.bytes_copied, 0, memory_order_relaxed);
+  atomic_store_explicit(&counters.bytes_moved, 0, memory_order_relaxed);
+  for (size_t i = 0; i < STRLIB_NUM_OPERATIONS; i++) {
+    atomic_store_explicit(&counters.calls[i], 0, memory_order_relaxed);
+    atomic_store_explicit(&counters.ns[i], 0, memory_order_relaxed);
+  }
+#endif
 
   return (strlib_result_t){
       .code = STRLIB_E_SUCCESS,
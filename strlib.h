@@ -37,6 +37,18 @@
 // Must use standard c types.
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/*
+** Constants defined by the library.
+*/
+
+// Capacity (including the null terminator) of the buffer stored inline in
+// every strlib string. Contents that fit are kept without a heap allocation.
+#define STRLIB_SMALL_CAPACITY 24
+
+// Number of public operations a stats snapshot has room for.
+#define STRLIB_STATS_MAX_OPERATIONS 128
 
 /*
 ** Type definitions reserved by the library.
@@ -46,18 +58,122 @@
 // internally.
 typedef struct strlib_str_t strlib_str_t;
 
+// Opaque structure types for the built-in allocators. The implementation of
+// which is managed internally.
+typedef struct strlib_arena_t strlib_arena_t;
+typedef struct strlib_pool_t strlib_pool_t;
+
+// Opaque structure type for streaming searches. The implementation of which
+// is managed internally.
+typedef struct strlib_stream_t strlib_stream_t;
+
+// Opaque structure type for compiled multi-pattern searches. The
+// implementation of which is managed internally.
+typedef struct strlib_matcher_t strlib_matcher_t;
+
+// Opaque structure type for resumable substring searches. The
+// implementation of which is managed internally.
+typedef struct strlib_finder_t strlib_finder_t;
+
+// Opaque structure type for batches of edits applied together. The
+// implementation of which is managed internally.
+typedef struct strlib_edits_t strlib_edits_t;
+
+// Opaque structure type for tables of interned strings. The implementation
+// of which is managed internally.
+typedef struct strlib_intern_t strlib_intern_t;
+
+// Callbacks used by a strlib string to manage its memory. `ctx` is passed back
+// to every callback, and the sizes of existing blocks are always provided so
+// that allocators do not need to track them.
+typedef struct {
+  void *(*alloc)(void *ctx, size_t size);  // Returns NULL when out of memory.
+  void *(*resize)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+  void (*release)(void *ctx, void *ptr, size_t size);
+  void *ctx;  // Allocator state handed to the callbacks.
+} strlib_allocator_t;
+
 // A pair of size_t that are used to define slices.
 typedef struct {
   size_t start;  // Beginning index.
   size_t end;    // Ending index.
 } strlib_slice_t;
 
+// A non-owning, read-only view of `length` characters starting at `chars`.
+// Views are not null terminated. A view borrowed from a strlib string is
+// invalidated by any modification of that strlib string.
+typedef struct {
+  const char *chars;  // First viewed character.
+  size_t length;      // Number of viewed characters.
+} strlib_view_t;
+
+// A growable array of slices filled by the find_all functions. Start from
+// a zeroed struct and release it with strlib_slices_free. Passing it again
+// reuses the array, which is only ever grown.
+typedef struct {
+  strlib_slice_t *slices;  // Slices found.
+  size_t num_slices;       // Number of slices found.
+  size_t capacity;         // Number of slices the array has room for.
+} strlib_slices_t;
+
+// Callback receiving every match found by a streaming search, as the slice
+// of absolute offsets it covers in the stream. `ctx` is passed back as given.
+typedef void (*strlib_match_callback_t)(void *ctx, strlib_slice_t match);
+
+// A match found by a multi-pattern search.
+typedef struct {
+  size_t pattern;        // Index of the pattern that was matched.
+  strlib_slice_t slice;  // Slice of the characters it matched.
+} strlib_match_t;
+
+// Strategies used to compute a new capacity when a strlib string outgrows its
+// current one.
+typedef enum {
+  STRLIB_GROWTH_GEOMETRIC,  // Double small buffers, then grow by half (1.5x).
+  STRLIB_GROWTH_EXACT,      // Grow to exactly the capacity that is required.
+  STRLIB_GROWTH_PAGE,       // Round the required capacity up to whole pages.
+  STRLIB_GROWTH_CAPPED,     // Geometric, but never grow by more than `limit`.
+} strlib_growth_strategy_t;
+
+// Growth policy of a strlib string. (`limit` is only used by capped growth.)
+typedef struct {
+  strlib_growth_strategy_t strategy;  // Strategy used to grow capacity.
+  size_t limit;                       // Maximum growth step in bytes.
+} strlib_growth_policy_t;
+
+// Storage used to hold the characters of a strlib string.
+typedef enum {
+  STRLIB_REPRESENTATION_FLAT,  // One contiguous array of characters.
+  STRLIB_REPRESENTATION_ROPE,  // A piece table with O(log n) edits.
+} strlib_representation_t;
+
+// Call count and cumulative latency of one public operation.
+typedef struct {
+  const char *name;             // Name of the function, e.g. "strlib_set".
+  unsigned long long calls;     // Number of calls made.
+  unsigned long long total_ns;  // Nanoseconds spent in the calls.
+} strlib_operation_stats_t;
+
+// Counters gathered by a library built with STRLIB_INSTRUMENT defined. They
+// are all zero, and `enabled` is false, in any other build.
+typedef struct {
+  bool enabled;                      // Whether the counters are gathered.
+  unsigned long long allocations;    // Allocations requested.
+  unsigned long long reallocations;  // Resizes of allocations requested.
+  unsigned long long releases;       // Allocations released.
+  unsigned long long bytes_copied;   // Bytes copied between buffers.
+  unsigned long long bytes_moved;    // Bytes moved within a buffer.
+  size_t num_operations;             // Number of entries in `operations`.
+  strlib_operation_stats_t operations[STRLIB_STATS_MAX_OPERATIONS];
+} strlib_stats_t;
+
 // Result codes returned in the result type. Useful for operation validation.
 typedef enum {
   STRLIB_E_SUCCESS,    // Code for success.
   STRLIB_E_NO_MEMORY,  // Code for out of memory.
   STRLIB_E_BAD_SIZE,   // Code for size mismatch.
   STRLIB_E_BAD_INDEX,  // Code for bad index into string.
+  STRLIB_E_IO,         // Code for a file that cannot be opened or mapped.
 } strlib_result_code_t;
 
 // Result type for the libary that provides an error code.
@@ -77,7 +193,9 @@ typedef struct {
 ** Side Effects: Any side effects that occur during function execution.
 */
 
-/* Description: Initializes a strlib string `s`.
+/* Description: Initializes an empty strlib string `s`. Short contents are
+**     stored inline, so no character buffer is allocated until the string
+**     outgrows STRLIB_SMALL_CAPACITY.
 ** Parameters:
 **     s - A pointer to the memory address where the strlib string is to be
 **             held. Note that this is a reference to the ADDRESS where the
@@ -91,6 +209,102 @@ typedef struct {
 */
 strlib_result_t strlib_init(strlib_str_t **s);
 
+/* Description: Initializes an empty strlib string `s` whose memory, including
+**     the strlib string itself, is managed by `allocator`.
+** Parameters:
+**     s         - A pointer to the memory address where the strlib string is
+**                     to be held.
+**     allocator - The allocator to be used. It is referenced rather than
+**                     copied, so it must outlive the strlib string.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) An strlib string at the the address stored in the pointer `s`.
+*/
+strlib_result_t strlib_init_with_allocator(strlib_str_t **s,
+                                           const strlib_allocator_t *allocator);
+
+/* Description: Initializes an empty strlib string `s` stored with
+**     `representation` and managed by `allocator`. Rope strings keep their
+**     contents as pieces of immutable buffers in a balanced tree, so that
+**     inserting and removing characters anywhere costs O(log n) instead of
+**     moving the rest of the string. Operations without a rope counterpart,
+**     such as searches, first gather the pieces into one array again.
+** Parameters:
+**     s              - A pointer to the memory address where the strlib
+**                          string is to be held.
+**     representation - The storage used for the characters of the string.
+**     allocator      - The allocator to be used, or NULL for the default.
+**                          It is referenced rather than copied, so it must
+**                          outlive the strlib string.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) An strlib string at the the address stored in the pointer `s`.
+*/
+strlib_result_t strlib_init_with_representation(
+    strlib_str_t **s, const strlib_representation_t representation,
+    const strlib_allocator_t *allocator);
+
+/* Description: Makes the strlib string `s` safe to share between threads.
+**     Every operation on a shared string then locks it for its duration:
+**     reads, such as the get and find functions, lock it shared and run in
+**     parallel, while modifications lock it exclusively. Reads of rope
+**     strings gather their pieces and so lock them exclusively as well.
+**     Views borrowed from a shared string are not protected by the lock and
+**     must only be read while no thread modifies the string.
+** Parameters:
+**     s - A pointer to where the strlib string is to be held.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate the lock.
+** Side Effects:
+**     1) The strlib string `s` owns a lock, released by strlib_free. This
+**         function itself must be called before `s` is shared.
+*/
+strlib_result_t strlib_share(strlib_str_t *s);
+
+/* Description: Initializes a strlib string `s` holding the contents of the
+**     file at `path`, which is mapped into memory rather than read. See
+**     strlib_map.
+** Parameters:
+**     s         - A pointer to the memory address where the strlib string
+**                     is to be held.
+**     path      - The path of the file.
+**     allocator - The allocator to be used, or NULL for the default.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+**     STRLIB_E_IO        - When the file cannot be opened or mapped.
+** Side Effects:
+**     1) An strlib string at the the address stored in the pointer `s`.
+**     2) On failure `s` is set to NULL, with nothing left to free.
+*/
+strlib_result_t strlib_init_from_file(strlib_str_t **s, const char *path,
+                                      const strlib_allocator_t *allocator);
+
+/* Description: Sets the contents of the strlib string `s` to those of the
+**     open regular file `fd` without copying them. The file is mapped
+**     read-only and privately, and the getters and searches read straight
+**     from the mapping. The first modification copies the contents to the
+**     heap, except for strlib_set and strlib_clear, which drop them. Mapped
+**     contents report a capacity of 0. The file must not be truncated while
+**     it is mapped.
+** Parameters:
+**     s  - A pointer to where the strlib string is to be held.
+**     fd - The descriptor of the file, which may be closed afterwards.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to reserve the mapping.
+**     STRLIB_E_IO        - When `fd` is not a regular file that can be
+**                          mapped, in which case `s` is left unchanged.
+** Side Effects:
+**     1) The previous contents of strlib string `s` are released.
+*/
+strlib_result_t strlib_map(strlib_str_t *s, const int fd);
+
 /* Description: Finds character `c` in strlib string `s` and stores indicies
 **     into array `position`.
 ** Parameters:
@@ -112,8 +326,56 @@ strlib_result_t strlib_find_char(strlib_str_t *s, size_t *positions,
                                  size_t *num_positions,
                                  const size_t positions_size, const char c);
 
+/* Description: Finds every character of strlib string `s` which is one of
+**     the characters in `set` and stores indicies into array `positions`.
+** Parameters:
+**     s             - A pointer to where the strlib string is to be held.
+**     positions     - The indicies where the characters should be found.
+**     num_positions - The number of positions found.
+**     positons_size - The maximum number of positions that can be stored.
+**     set           - The characters to be found, in any order.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_SIZE  - When the positions buffer would be overrun.
+** Side Effects:
+**     1) The size_t array `positions` is updated with the indicies where
+**         characters of `set` can be found, in ascending order.
+**     1) The size_t value pointed to `num_positions` is updated with the
+**         number of characters that were found.
+*/
+strlib_result_t strlib_find_any_char(strlib_str_t *s, size_t *positions,
+                                     size_t *num_positions,
+                                     const size_t positions_size,
+                                     const char *set);
+
+/* Description: Finds every character of strlib string `s` which is one of
+**     the `set_length` characters of `set`. Behaves like
+**     strlib_find_any_char, but `set` may contain null characters.
+** Parameters:
+**     s             - A pointer to where the strlib string is to be held.
+**     positions     - The indicies where the characters should be found.
+**     num_positions - The number of positions found.
+**     positons_size - The maximum number of positions that can be stored.
+**     set           - The characters to be found, in any order.
+**     set_length    - The number of characters in `set`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_SIZE  - When the positions buffer would be overrun.
+** Side Effects:
+**     1) The size_t array `positions` is updated with the indicies where
+**         characters of `set` can be found, in ascending order.
+**     1) The size_t value pointed to `num_positions` is updated with the
+**         number of characters that were found.
+*/
+strlib_result_t strlib_find_any_char_n(strlib_str_t *s, size_t *positions,
+                                       size_t *num_positions,
+                                       const size_t positions_size,
+                                       const char *set,
+                                       const size_t set_length);
+
 /* Description: Finds sub-string `substr` in strlib string `s` and stores
-**     indicies into array `position`.
+**     indicies into array `position`. Overlapping occurences are all
+**     reported, and an empty `substr` is never found.
 ** Parameters:
 **     s             - A pointer to where the strlib string is to be held.
 **     slices        - The slices where the characters should be found.
@@ -134,6 +396,179 @@ strlib_result_t strlib_find_substr(strlib_str_t *s, strlib_slice_t *slices,
                                    const size_t positions_size,
                                    const char *substr);
 
+/* Description: Finds the `substr_length` characters of `substr` in strlib
+**     string `s`. Behaves like strlib_find_substr, but `substr` may
+**     contain null characters.
+** Parameters:
+**     s             - A pointer to where the strlib string is to be held.
+**     slices        - The slices where the characters should be found.
+**     num_positions - The number of positions found.
+**     positons_size - The maximum number of positions that can be stored.
+**     substr        - The chars to be found.
+**     substr_length - The number of characters in `substr`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_SIZE  - When the positions buffer would be overrun.
+** Side Effects:
+**     1) The strlib_slice_t array `slices` is updated with the slices
+**         where `substr` can be found.
+**     1) The size_t value pointed to `num_positions` is updated with the
+**         number of occurences of `substr` that were found.
+*/
+strlib_result_t strlib_find_substr_n(strlib_str_t *s, strlib_slice_t *slices,
+                                     size_t *num_positions,
+                                     const size_t positions_size,
+                                     const char *substr,
+                                     const size_t substr_length);
+
+/* Description: Finds the characters of view `substr` in strlib string `s`
+**     and stores indicies into array `slices`. Behaves like
+**     strlib_find_substr, but `substr` may contain null characters.
+** Parameters:
+**     s             - A pointer to where the strlib string is to be held.
+**     slices        - The slices where the characters should be found.
+**     num_positions - The number of positions found.
+**     positons_size - The maximum number of positions that can be stored.
+**     substr        - The view of the chars to be found.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_SIZE  - When the positions buffer would be overrun.
+** Side Effects:
+**     1) The strlib_slice_t array `slices` is updated with the slices
+**         where `substr` can be found.
+**     1) The size_t value pointed to `num_positions` is updated with the
+**         number of occurences of `substr` that were found.
+*/
+strlib_result_t strlib_find_substr_view(strlib_str_t *s,
+                                        strlib_slice_t *slices,
+                                        size_t *num_positions,
+                                        const size_t positions_size,
+                                        const strlib_view_t substr);
+
+/* Description: Finds every occurence of the characters of view `substr` in
+**     strlib string `s` and stores their slices into `results`, which
+**     grows as needed. Matches are found like strlib_find_substr_view.
+** Parameters:
+**     s       - A pointer to where the strlib string is to be held.
+**     results - The slices where the characters can be found.
+**     substr  - The view of the chars to be found.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) `results` holds the slices where `substr` can be found, or those
+**         found before running out of memory.
+*/
+strlib_result_t strlib_find_all(strlib_str_t *s, strlib_slices_t *results,
+                                const strlib_view_t substr);
+
+/* Description: Finds every character of strlib string `s` which is in the
+**     null terminated `set` and stores their indicies into `results`, as
+**     slices which start and end at the same index.
+** Parameters:
+**     s       - A pointer to where the strlib string is to be held.
+**     results - The slices where the characters can be found.
+**     set     - The characters to be found.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) `results` holds the indicies of the characters found, or those
+**         found before running out of memory.
+*/
+strlib_result_t strlib_find_all_any_char(strlib_str_t *s,
+                                         strlib_slices_t *results,
+                                         const char *set);
+
+/* Description: Finds every character of strlib string `s` which is one of
+**     the `set_length` characters of `set`. Behaves like
+**     strlib_find_all_any_char, but `set` may contain null characters.
+** Parameters:
+**     s          - A pointer to where the strlib string is to be held.
+**     results    - The slices where the characters can be found.
+**     set        - The characters to be found.
+**     set_length - The number of characters in `set`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) `results` holds the indicies of the characters found, or those
+**         found before running out of memory.
+*/
+strlib_result_t strlib_find_all_any_char_n(strlib_str_t *s,
+                                           strlib_slices_t *results,
+                                           const char *set,
+                                           const size_t set_length);
+
+/* Description: Releases the array of the slices `results`.
+** Parameters:
+**     results - The slices filled by the find_all functions.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) `results` is zeroed, ready to be filled again.
+*/
+strlib_result_t strlib_slices_free(strlib_slices_t *results);
+
+/* Description: Initializes a resumable search `finder` for the characters
+**     of view `needle`, which finds one match per call of strlib_find_next
+**     starting from index 0.
+** Parameters:
+**     finder - A pointer to the memory address where the finder is to be
+**                  held.
+**     needle - The characters to be found. They are copied.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) A finder at the the address stored in the pointer `finder`.
+*/
+strlib_result_t strlib_finder_init(strlib_finder_t **finder,
+                                   const strlib_view_t needle);
+
+/* Description: Finds the next match of `finder` in strlib string `s`, at
+**     or after the index the finder is at, and moves the finder to the
+**     index after the start of the match. Like strlib_find_substr,
+**     overlapping matches are all found, unless the finder is moved past
+**     them with strlib_finder_seek.
+** Parameters:
+**     finder - A pointer to where the finder is to be held.
+**     s      - A pointer to where the strlib string is to be held.
+**     match  - The slice of the match found.
+**     found  - Whether a match was found.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The bool value pointed to by `found` is updated with whether a
+**         match was found, and if so `match` is updated with its slice.
+*/
+strlib_result_t strlib_find_next(strlib_finder_t *finder, strlib_str_t *s,
+                                 strlib_slice_t *match, bool *found);
+
+/* Description: Moves `finder` to index `position`, where the next search
+**     starts.
+** Parameters:
+**     finder   - A pointer to where the finder is to be held.
+**     position - The index to search from.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The next match found by `finder` starts at or after `position`.
+*/
+strlib_result_t strlib_finder_seek(strlib_finder_t *finder,
+                                   const size_t position);
+
+/* Description: Destructs the finder `finder`.
+** Parameters:
+**     finder - A pointer to where the finder is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) `finder` is freed and must no longer be used.
+*/
+strlib_result_t strlib_finder_free(strlib_finder_t *finder);
+
 /* Description: Inserts character `c` into strlib string `s` at index
 **     `position`.
 ** Parameters:
@@ -165,6 +600,24 @@ strlib_result_t strlib_insert_chars(strlib_str_t *s, const char *cs,
                                     const size_t len_cs, const size_t position,
                                     const bool reversed);
 
+/* Description: Inserts the characters of view `view` into strlib string `s`
+**     at index `position`.
+** Parameters:
+**     s        - A pointer to where the strlib string is to be held.
+**     view     - The view of the characters to be inserted. It must not be
+**                    borrowed from `s` itself.
+**     position - The index where the characters should be inserted.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The strlib string `s` is updated with the value `view`
+**         appropriately.
+*/
+strlib_result_t strlib_insert_view(strlib_str_t *s, const strlib_view_t view,
+                                   const size_t position);
+
 /* Description: Copies the contents of the strlib string `s` into
 **     the character array `buf`, up to the size of `size`.
 ** Parameters:
@@ -215,132 +668,755 @@ strlib_result_t strlib_get_char(const strlib_str_t *s, char *c,
 strlib_result_t strlib_get_slice(const strlib_str_t *s, char *buf,
                                  const size_t size, const strlib_slice_t slice);
 
-/* Description: Stores the length of the strlib string `s` in `length`.
+/* Description: Borrows the contents of the strlib string `s` into the view
+**     `view` without copying. The pieces of a rope string are first
+**     gathered into one array.
 ** Parameters:
-**     s      - A pointer to where the strlib string is to be held.
-**     length - The size_t location where length is stored.
+**     s    - A pointer to where the strlib string is to be held.
+**     view - The view location to store the borrowed contents.
 ** Results:
-**     STRLIB_E_SUCCESS - When the function exits successfully.
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
 ** Side Effects:
-**     1) The length of strlib string `s` is placed into `length`.
+**     1) `view` refers to the contents of strlib string `s` until `s` is
+**         next modified.
 */
-strlib_result_t strlib_get_length(const strlib_str_t *s, size_t *length);
+strlib_result_t strlib_get_view(const strlib_str_t *s, strlib_view_t *view);
 
-/* Description: Stores the capacity of the strlib string `s` in `capacity`.
+/* Description: Borrows the characters of the strlib string `s` from
+**     position `slice.start` to position `slice.end` into the view `view`
+**     without copying. The pieces of a rope string are first gathered into
+**     one array.
 ** Parameters:
-**     s        - A pointer to where the strlib string is to be held.
-**     capacity - The size_t location where capacity is stored.
+**     s     - A pointer to where the strlib string is to be held.
+**     view  - The view location to store the borrowed characters.
+**     slice - The slice defining the chars to be borrowed from the string.
 ** Results:
-**     STRLIB_E_SUCCESS - When the function exits successfully.
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+**     STRLIB_E_BAD_INDEX - When the slice is reversed or out of bounds.
 ** Side Effects:
-**     1) The capacity of strlib string `s` is placed into `capacity`.
+**     1) `view` refers to the characters of strlib string `s` until `s` is
+**         next modified.
 */
-strlib_result_t strlib_get_capacity(const strlib_str_t *s, size_t *capacity);
+strlib_result_t strlib_get_slice_view(const strlib_str_t *s,
+                                      strlib_view_t *view,
+                                      const strlib_slice_t slice);
 
-/* Description: Replaces the character of the strlib string `s` at
-**     position `position` with the character `c`.
+/* Description: Compares the strlib string `s` with the characters of view
+**     `view`, byte by byte as unsigned chars.
 ** Parameters:
-**     s        - A pointer to where the strlib string is to be held.
-**     c        - The value to replace with in the strlib string.
-**     position - The index where the character should be replaced.
+**     s      - A pointer to where the strlib string is to be held.
+**     view   - The view of the characters to compare against.
+**     result - The location where the comparison result is stored.
 ** Results:
 **     STRLIB_E_SUCCESS   - When the function exits successfully.
-**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
 ** Side Effects:
-**     1) The charcter in position `position` of strlib string `s`
-**         is replaced with `c`.
+**     1) `result` is set to -1, 0 or 1 when `s` orders before, equal to or
+**         after `view`. A prefix orders before the longer string.
 */
-strlib_result_t strlib_replace_char(strlib_str_t *s, const char c,
-                                    const size_t position);
+strlib_result_t strlib_compare_view(const strlib_str_t *s,
+                                    const strlib_view_t view, int *result);
 
-/* Description: Replaces the characters of the strlib string `s` at
-**     position `position` with the characters `cs`.
+/* Description: Compares the strlib strings `a` and `b`, byte by byte as
+**     unsigned chars, in the order of strlib_compare_view.
 ** Parameters:
-**     s        - A pointer to where the strlib string is to be held.
-**     cs       - The characters to replace with in the strlib string.
-**     slice    - The slice defining the chars to be retieved the string.
+**     a      - A pointer to where the first strlib string is to be held.
+**     b      - A pointer to where the second strlib string is to be held.
+**     result - The location where the comparison result is stored.
 ** Results:
 **     STRLIB_E_SUCCESS   - When the function exits successfully.
-**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
 ** Side Effects:
-**     1) The charcter in position `position` of strlib string `s`
-**         is replaced with `c`.
+**     1) `result` is set to -1, 0 or 1 when `a` orders before, equal to or
+**         after `b`. A prefix orders before the longer string.
 */
-strlib_result_t strlib_replace_slice(strlib_str_t *s, const char *cs,
-                                     const strlib_slice_t slice);
+strlib_result_t strlib_compare(const strlib_str_t *a, const strlib_str_t *b,
+                               int *result);
 
-/* Description: Replaces the characters of the strlib string `s` that
-**     match sub-string `substr` with the characters `cs`.
+/* Description: Checks whether the strlib strings `a` and `b` hold the same
+**     contents. Strings of different lengths, or whose cached hashes
+**     differ, are told apart without reading their characters.
 ** Parameters:
-**     s      - A pointer to where the strlib string is to be held.
-**     substr - The characters to replace in the strlib string.
-**     cs     - The characters to replace with in the strlib string.
+**     a      - A pointer to where the first strlib string is to be held.
+**     b      - A pointer to where the second strlib string is to be held.
+**     result - The location where the outcome is stored.
 ** Results:
 **     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
 ** Side Effects:
-**     1) The charcters matching `substr` in strlib string `s`
-**         are replaced with `cs`.
+**     1) `result` is set to true if the contents are equal, else false.
 */
-strlib_result_t strlib_replace_substr(strlib_str_t *s, const char *substr,
-                                      const char *cs);
+strlib_result_t strlib_equals(const strlib_str_t *a, const strlib_str_t *b,
+                              bool *result);
 
-/* Description: Remove the character of the strlib string `s` at
-**     position `position`.
+/* Description: Checks whether the strlib string `s` holds exactly the
+**     characters of view `view`.
 ** Parameters:
-**     s        - A pointer to where the strlib string is to be held.
-**     position - The index where the character should be replaced.
+**     s      - A pointer to where the strlib string is to be held.
+**     view   - The view of the characters to compare against.
+**     result - The location where the outcome is stored.
 ** Results:
 **     STRLIB_E_SUCCESS   - When the function exits successfully.
-**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
 ** Side Effects:
-**     1) The charcter in position `position` of strlib string `s`
-**         is removed.
+**     1) `result` is set to true if the contents are equal, else false.
 */
-strlib_result_t strlib_remove_char(strlib_str_t *s, const size_t position);
+strlib_result_t strlib_equals_view(const strlib_str_t *s,
+                                   const strlib_view_t view, bool *result);
 
-/* Description: Remove the characters of the strlib string `s` between
-**     start position `start_pos` and end position `end_pos`.
+/* Description: Checks whether the strlib string `s` begins with the
+**     characters of view `prefix`.
 ** Parameters:
-**     s        - A pointer to where the strlib string is to be held.
-**     slice    - The slice defining the chars to be retieved the string.
+**     s      - A pointer to where the strlib string is to be held.
+**     prefix - The view of the characters expected first.
+**     result - The location where the outcome is stored.
 ** Results:
 **     STRLIB_E_SUCCESS   - When the function exits successfully.
-**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
 ** Side Effects:
-**     1) The charcters from position `start_pos` to `end_pos` of strlib string
-**         `s` are removed.
+**     1) `result` is set to true if `s` begins with `prefix`, else false.
+**         Every string begins with the empty view.
 */
-strlib_result_t strlib_remove_slice(strlib_str_t *s,
-                                    const strlib_slice_t slice);
+strlib_result_t strlib_starts_with(const strlib_str_t *s,
+                                   const strlib_view_t prefix, bool *result);
 
-/* Description: Removes sub-string `substr` in strlib string `s`.
+/* Description: Checks whether the strlib string `s` ends with the
+**     characters of view `suffix`.
 ** Parameters:
-**     s             - A pointer to where the strlib string is to be held.
-**     substr        - the subsequence of chars to be removed.
+**     s      - A pointer to where the strlib string is to be held.
+**     suffix - The view of the characters expected last.
+**     result - The location where the outcome is stored.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) `result` is set to true if `s` ends with `suffix`, else false.
+**         Every string ends with the empty view.
+*/
+strlib_result_t strlib_ends_with(const strlib_str_t *s,
+                                 const strlib_view_t suffix, bool *result);
+
+/* Description: Sorts the `count` strlib strings pointed to by `strs` into
+**     the order of strlib_compare, using a most significant digit radix
+**     sort that reads the characters of every string 8 at a time.
+** Parameters:
+**     strs  - The array of strlib strings to be sorted.
+**     count - The number of strlib strings in `strs`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The pointers of `strs` are reordered, the strings themselves are
+**         left unchanged. Equal strings end up in no particular order.
+**     2) Shared strings are locked for reading until the sort ends.
+*/
+strlib_result_t strlib_sort(strlib_str_t **strs, const size_t count);
+
+/* Description: Stores the length of the strlib string `s` in `length`.
+** Parameters:
+**     s      - A pointer to where the strlib string is to be held.
+**     length - The size_t location where length is stored.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The length of strlib string `s` is placed into `length`.
+*/
+strlib_result_t strlib_get_length(const strlib_str_t *s, size_t *length);
+
+/* Description: Stores the capacity of the strlib string `s` in `capacity`.
+**     For a rope string being edited this is the size of all the buffers
+**     its pieces are held in.
+** Parameters:
+**     s        - A pointer to where the strlib string is to be held.
+**     capacity - The size_t location where capacity is stored.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The capacity of strlib string `s` is placed into `capacity`.
+*/
+strlib_result_t strlib_get_capacity(const strlib_str_t *s, size_t *capacity);
+
+/* Description: Stores the growth policy of the strlib string `s` in `policy`.
+** Parameters:
+**     s      - A pointer to where the strlib string is to be held.
+**     policy - The location where the growth policy is stored.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The growth policy of strlib string `s` is placed into `policy`.
+*/
+strlib_result_t strlib_get_growth_policy(const strlib_str_t *s,
+                                         strlib_growth_policy_t *policy);
+
+/* Description: Sets the policy used to grow the capacity of the strlib
+**     string `s` when its contents no longer fit. Strings start out with
+**     STRLIB_GROWTH_GEOMETRIC.
+** Parameters:
+**     s      - A pointer to where the strlib string is to be held.
+**     policy - The growth policy to be used from now on.
+** Results:
+**     STRLIB_E_SUCCESS  - When the function exits successfully.
+**     STRLIB_E_BAD_SIZE - When a capped policy has a `limit` of zero.
+** Side Effects:
+**     1) Future growth of strlib string `s` follows `policy`.
+*/
+strlib_result_t strlib_set_growth_policy(strlib_str_t *s,
+                                         const strlib_growth_policy_t policy);
+
+/* Description: Makes sure the strlib string `s` has a capacity of at least
+**     `capacity`, so that it can be filled without further allocation.
+** Parameters:
+**     s        - A pointer to where the strlib string is to be held.
+**     capacity - The minimum capacity, including the null terminator.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The capacity of strlib string `s` is raised to exactly `capacity`
+**         if it was smaller.
+*/
+strlib_result_t strlib_reserve(strlib_str_t *s, const size_t capacity);
+
+/* Description: Releases the unused capacity of the strlib string `s`.
+** Parameters:
+**     s - A pointer to where the strlib string is to be held.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to reallocate memory.
+** Side Effects:
+**     1) The capacity of strlib string `s` is reduced to its length plus the
+**         null terminator, or to STRLIB_SMALL_CAPACITY when the contents fit
+**         inline.
+*/
+strlib_result_t strlib_shrink_to_fit(strlib_str_t *s);
+
+/* Description: Replaces the character of the strlib string `s` at
+**     position `position` with the character `c`.
+** Parameters:
+**     s        - A pointer to where the strlib string is to be held.
+**     c        - The value to replace with in the strlib string.
+**     position - The index where the character should be replaced.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+** Side Effects:
+**     1) The charcter in position `position` of strlib string `s`
+**         is replaced with `c`.
+*/
+strlib_result_t strlib_replace_char(strlib_str_t *s, const char c,
+                                    const size_t position);
+
+/* Description: Replaces the characters of the strlib string `s` at
+**     position `position` with the characters `cs`.
+** Parameters:
+**     s        - A pointer to where the strlib string is to be held.
+**     cs       - The characters to replace with in the strlib string.
+**     slice    - The slice defining the chars to be retieved the string.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+** Side Effects:
+**     1) The charcter in position `position` of strlib string `s`
+**         is replaced with `c`.
+*/
+strlib_result_t strlib_replace_slice(strlib_str_t *s, const char *cs,
+                                     const strlib_slice_t slice);
+
+/* Description: Replaces the characters of the strlib string `s` within
+**     `slice` with the `cs_length` characters of `cs`, which may contain
+**     null characters.
+** Parameters:
+**     s         - A pointer to where the strlib string is to be held.
+**     cs        - The characters to replace with in the strlib string.
+**     cs_length - The number of characters in `cs`.
+**     slice     - The slice defining the chars to be replaced.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+** Side Effects:
+**     1) The charcters within `slice` of strlib string `s` are replaced
+**         with `cs`.
+*/
+strlib_result_t strlib_replace_slice_n(strlib_str_t *s, const char *cs,
+                                       const size_t cs_length,
+                                       const strlib_slice_t slice);
+
+/* Description: Replaces the characters of the strlib string `s` within
+**     `slice` with the characters of view `view`.
+** Parameters:
+**     s     - A pointer to where the strlib string is to be held.
+**     view  - The view of the characters to replace with. It must not be
+**                 borrowed from `s` itself.
+**     slice - The slice defining the chars to be replaced in the string.
 ** Results:
 **     STRLIB_E_SUCCESS   - When the function exits successfully.
-**     STRLIB_E_BAD_SIZE  - When the positions buffer would be overrun.
-**                              (propagates from strlib_str_find_substr)
 **     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
-**                              (propagates from strlib_str_remove_slice)
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The charcters within `slice` of strlib string `s` are replaced
+**         with `view`.
+*/
+strlib_result_t strlib_replace_slice_view(strlib_str_t *s,
+                                          const strlib_view_t view,
+                                          const strlib_slice_t slice);
+
+/* Description: Replaces the characters of the strlib string `s` that
+**     match sub-string `substr` with the characters `cs`. Matches are found
+**     left to right without overlapping, and the result is built in a
+**     single pass.
+** Parameters:
+**     s      - A pointer to where the strlib string is to be held.
+**     substr - The characters to replace in the strlib string.
+**     cs     - The characters to replace with in the strlib string.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The charcters matching `substr` in strlib string `s`
+**         are replaced with `cs`.
+*/
+strlib_result_t strlib_replace_substr(strlib_str_t *s, const char *substr,
+                                      const char *cs);
+
+/* Description: Replaces the `substr_length` characters of `substr` in the
+**     strlib string `s` with the `cs_length` characters of `cs`. Behaves
+**     like strlib_replace_substr, but both may contain null characters.
+** Parameters:
+**     s             - A pointer to where the strlib string is to be held.
+**     substr        - The characters to replace in the strlib string.
+**     substr_length - The number of characters in `substr`.
+**     cs            - The characters to replace with in the strlib string.
+**     cs_length     - The number of characters in `cs`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The charcters matching `substr` in strlib string `s`
+**         are replaced with `cs`.
+*/
+strlib_result_t strlib_replace_substr_n(strlib_str_t *s, const char *substr,
+                                        const size_t substr_length,
+                                        const char *cs,
+                                        const size_t cs_length);
+
+/* Description: Replaces at most `max_replacements` of the leftmost matches
+**     of sub-string `substr` in the strlib string `s` with the characters
+**     `cs`.
+** Parameters:
+**     s                - A pointer to where the strlib string is to be held.
+**     substr           - The characters to replace in the strlib string.
+**     cs               - The characters to replace with in the strlib string.
+**     max_replacements - The maximum number of matches to replace.
+**     num_replaced     - The number of matches that were replaced.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) Up to `max_replacements` charcters matching `substr` in strlib
+**         string `s` are replaced with `cs`.
+**     2) The size_t value pointed to by `num_replaced` is updated with the
+**         number of replacements made.
+*/
+strlib_result_t strlib_replace_substr_max(strlib_str_t *s, const char *substr,
+                                          const char *cs,
+                                          const size_t max_replacements,
+                                          size_t *num_replaced);
+
+/* Description: Replaces at most `max_replacements` of the leftmost matches
+**     of the `substr_length` characters of `substr` in the strlib string
+**     `s` with the `cs_length` characters of `cs`. Behaves like
+**     strlib_replace_substr_max, but both may contain null characters.
+** Parameters:
+**     s                - A pointer to where the strlib string is to be held.
+**     substr           - The characters to replace in the strlib string.
+**     substr_length    - The number of characters in `substr`.
+**     cs               - The characters to replace with in the strlib string.
+**     cs_length        - The number of characters in `cs`.
+**     max_replacements - The maximum number of matches to replace.
+**     num_replaced     - The number of matches that were replaced.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) Up to `max_replacements` charcters matching `substr` in strlib
+**         string `s` are replaced with `cs`.
+**     2) The size_t value pointed to by `num_replaced` is updated with the
+**         number of replacements made.
+*/
+strlib_result_t strlib_replace_substr_max_n(strlib_str_t *s,
+                                            const char *substr,
+                                            const size_t substr_length,
+                                            const char *cs,
+                                            const size_t cs_length,
+                                            const size_t max_replacements,
+                                            size_t *num_replaced);
+
+/* Description: Replaces the characters of every view of array `needles` in
+**     the strlib string `s` with those of the view at the same index of
+**     array `replacements`, in a single pass. At every index the longest
+**     needle starting there is replaced, and the search resumes after it,
+**     so replacements are never matched again. When needles are equal the
+**     first of them is used, and empty needles never match.
+** Parameters:
+**     s            - A pointer to where the strlib string is to be held.
+**     needles      - The characters to replace in the strlib string.
+**     replacements - The characters to replace each needle with.
+**     num_pairs    - The number of needles and of replacements.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+**     STRLIB_E_BAD_SIZE  - When the needles are too many or too long.
+** Side Effects:
+**     1) The leftmost-longest matches of `needles` in strlib string `s`
+**         are replaced with their `replacements`.
+*/
+strlib_result_t strlib_replace_many(strlib_str_t *s,
+                                    const strlib_view_t *needles,
+                                    const strlib_view_t *replacements,
+                                    const size_t num_pairs);
+
+/* Description: Remove the character of the strlib string `s` at
+**     position `position`.
+** Parameters:
+**     s        - A pointer to where the strlib string is to be held.
+**     position - The index where the character should be replaced.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+** Side Effects:
+**     1) The charcter in position `position` of strlib string `s`
+**         is removed.
+*/
+strlib_result_t strlib_remove_char(strlib_str_t *s, const size_t position);
+
+/* Description: Remove the characters of the strlib string `s` between
+**     start position `start_pos` and end position `end_pos`. A slice may
+**     end on the null terminator, which is itself never removed.
+** Parameters:
+**     s        - A pointer to where the strlib string is to be held.
+**     slice    - The slice defining the chars to be retieved the string.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_INDEX - When the function finds index out of bounds.
+** Side Effects:
+**     1) The charcters from position `start_pos` to `end_pos` of strlib string
+**         `s` are removed.
+*/
+strlib_result_t strlib_remove_slice(strlib_str_t *s,
+                                    const strlib_slice_t slice);
+
+/* Description: Removes sub-string `substr` in strlib string `s`. Matches
+**     are found left to right without overlapping and removed in a single
+**     pass.
+** Parameters:
+**     s             - A pointer to where the strlib string is to be held.
+**     substr        - the subsequence of chars to be removed.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
 ** Side Effects:
 **     1) The strlib string `s` has occurences of `substr` removed.
 */
 strlib_result_t strlib_remove_substr(strlib_str_t *s, const char *substr);
 
+/* Description: Removes the `substr_length` characters of `substr` from
+**     strlib string `s`. Behaves like strlib_remove_substr, but `substr`
+**     may contain null characters.
+** Parameters:
+**     s             - A pointer to where the strlib string is to be held.
+**     substr        - the subsequence of chars to be removed.
+**     substr_length - The number of characters in `substr`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+** Side Effects:
+**     1) The strlib string `s` has occurences of `substr` removed.
+*/
+strlib_result_t strlib_remove_substr_n(strlib_str_t *s, const char *substr,
+                                       const size_t substr_length);
+
+/* Description: Removes the characters of every slice in `slices` from the
+**     strlib string `s` in a single pass. Slices are given in positions of
+**     the string before removal, in any order, and may overlap.
+** Parameters:
+**     s          - A pointer to where the strlib string is to be held.
+**     slices     - The slices defining the chars to be removed.
+**     num_slices - The number of slices in `slices`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_BAD_INDEX - When a slice reaches past the end of the string.
+**     STRLIB_E_NO_MEMORY - When unordered slices cannot be sorted.
+** Side Effects:
+**     1) The strlib string `s` has the characters of `slices` removed.
+*/
+strlib_result_t strlib_remove_slices(strlib_str_t *s,
+                                     const strlib_slice_t *slices,
+                                     const size_t num_slices);
+
+/* Description: Removes every character of the strlib string `s` which is one
+**     of the characters in `set`, in a single pass.
+** Parameters:
+**     s   - A pointer to where the strlib string is to be held.
+**     set - The characters to be removed, in any order.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The strlib string `s` has the characters of `set` removed.
+*/
+strlib_result_t strlib_remove_any_char(strlib_str_t *s, const char *set);
+
+/* Description: Removes every character of the strlib string `s` which is one
+**     of the `set_length` characters of `set`, which may contain null
+**     characters.
+** Parameters:
+**     s          - A pointer to where the strlib string is to be held.
+**     set        - The characters to be removed, in any order.
+**     set_length - The number of characters in `set`.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The strlib string `s` has the characters of `set` removed.
+*/
+strlib_result_t strlib_remove_any_char_n(strlib_str_t *s, const char *set,
+                                         const size_t set_length);
+
+/* Description: Creates an empty batch of edits. Edits are added to the
+**     batch in positions of a strlib string before any of them is made, and
+**     are then applied together by strlib_apply_edits.
+** Parameters:
+**     edits - A pointer to where the batch is to be held.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) A batch is allocated to `edits`, to be released with
+**         strlib_edits_free.
+*/
+strlib_result_t strlib_edits_init(strlib_edits_t **edits);
+
+/* Description: Adds an insertion of the characters of `view` at position
+**     `position` to the batch `edits`. Insertions at the same position are
+**     made in the order they were added, before any characters replaced
+**     there.
+** Parameters:
+**     edits    - The batch to add the edit to.
+**     position - The index to insert the characters at.
+**     view     - The characters to insert, which are copied to the batch.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The insertion is added to the batch `edits`.
+*/
+strlib_result_t strlib_edits_insert(strlib_edits_t *edits,
+                                    const size_t position,
+                                    const strlib_view_t view);
+
+/* Description: Adds a removal of the characters of `slice` to the batch
+**     `edits`.
+** Parameters:
+**     edits - The batch to add the edit to.
+**     slice - The slice defining the chars to be removed.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The removal is added to the batch `edits`.
+*/
+strlib_result_t strlib_edits_remove(strlib_edits_t *edits,
+                                    const strlib_slice_t slice);
+
+/* Description: Adds a replacement of the characters of `slice` with the
+**     characters of `view` to the batch `edits`. A reversed slice has them
+**     written in reverse order, as strlib_replace_slice_view does.
+** Parameters:
+**     edits - The batch to add the edit to.
+**     slice - The slice defining the chars to be replaced.
+**     view  - The characters to replace them with, which are copied to the
+**             batch.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The replacement is added to the batch `edits`.
+*/
+strlib_result_t strlib_edits_replace(strlib_edits_t *edits,
+                                     const strlib_slice_t slice,
+                                     const strlib_view_t view);
+
+/* Description: Applies every edit of the batch `edits` to the strlib
+**     string `s` at once, writing the new contents in a single pass. Edits
+**     may be added in any order but may not overlap. Slices may end on the
+**     null terminator, which is itself never removed.
+** Parameters:
+**     s     - A pointer to where the strlib string is to be held.
+**     edits - The batch of edits to apply.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+**     STRLIB_E_BAD_INDEX - When an edit is out of bounds or two edits
+**                          overlap, in which case `s` is left unchanged.
+** Side Effects:
+**     1) The strlib string `s` has the edits of `edits` made to it.
+**     2) The edits of `edits` are sorted by position.
+*/
+strlib_result_t strlib_apply_edits(strlib_str_t *s, strlib_edits_t *edits);
+
+/* Description: Empties the batch `edits`, keeping its memory for the next
+**     edits added.
+** Parameters:
+**     edits - The batch to empty.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+** Side Effects:
+**     1) The batch `edits` holds no edits.
+*/
+strlib_result_t strlib_edits_reset(strlib_edits_t *edits);
+
+/* Description: Releases the batch `edits`.
+** Parameters:
+**     edits - The batch to release.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+** Side Effects:
+**     1) The memory of `edits` is released.
+*/
+strlib_result_t strlib_edits_free(strlib_edits_t *edits);
+
 /* Description: Sets the contents of the strlib string `s` using
-**     the character array `buf`, up to the size of `size`.
+**     the character array `buf`, up to the size of `size`. Only the
+**     `size - 1` characters before the null terminator are copied, and
+**     the capacity of `s` is reused when they fit.
 ** Parameters:
 **     s    - A pointer to where the strlib string to hold the characters.
 **     buf  - The character array location with incoming contents.
-**     size - The size of the incoming buffer.
+**     size - The size of the incoming buffer, including its terminator.
 ** Results:
-**     STRLIB_E_SUCCESS  - When the function exits successfully.
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
 ** Side Effects:
 **     1) The contents of `buf` are placed into strlib string `s`.
 */
 strlib_result_t strlib_set(strlib_str_t *s, const char *buf, const size_t size);
 
+/* Description: Sets the contents of the strlib string `s` to exactly the
+**     `length` characters of `chars`, which may contain null characters.
+** Parameters:
+**     s      - A pointer to where the strlib string to hold the characters.
+**     chars  - The incoming characters. They need not be null terminated.
+**     length - The number of characters in `chars`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The characters of `chars` are placed into strlib string `s`.
+*/
+strlib_result_t strlib_set_n(strlib_str_t *s, const char *chars,
+                             const size_t length);
+
+/* Description: Empties the strlib string `s` in constant time, keeping its
+**     capacity for the next contents.
+** Parameters:
+**     s - A pointer to where the strlib string is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The strlib string `s` has a length of 0.
+*/
+strlib_result_t strlib_clear(strlib_str_t *s);
+
+/* Description: Sets the contents of the strlib string `s` to those of the
+**     strlib string `src`, reusing the capacity of `s` when they fit.
+** Parameters:
+**     s   - A pointer to where the strlib string is to be held.
+**     src - A pointer to where the strlib string to copy is held.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The contents of `src` are placed into strlib string `s`.
+*/
+strlib_result_t strlib_assign_from(strlib_str_t *s, const strlib_str_t *src);
+
+/* Description: Appends the characters of view `view` to the strlib string
+**     `s`.
+** Parameters:
+**     s    - A pointer to where the strlib string is to be held.
+**     view - The view of the characters to be appended.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The characters of `view` are placed after the contents of `s`.
+**         They must not refer to the contents of `s` itself.
+*/
+strlib_result_t strlib_append(strlib_str_t *s, const strlib_view_t view);
+
+/* Description: Appends the contents of the strlib string `src` to the
+**     strlib string `s`, which may be `src` itself.
+** Parameters:
+**     s   - A pointer to where the strlib string is to be held.
+**     src - The strlib string whose contents are appended.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The contents of `src` are placed after the contents of `s`.
+*/
+strlib_result_t strlib_append_str(strlib_str_t *s, const strlib_str_t *src);
+
+/* Description: Appends the characters of the `num_parts` views of `parts`
+**     to the strlib string `s` in order. Their total length is computed
+**     first, so that `s` grows at most once and every part is copied once.
+** Parameters:
+**     s         - A pointer to where the strlib string is to be held.
+**     parts     - The views of the characters to be appended.
+**     num_parts - The number of views in `parts`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The parts are placed after the contents of `s`. They must not
+**         refer to the contents of `s` itself.
+*/
+strlib_result_t strlib_concat(strlib_str_t *s, const strlib_view_t *parts,
+                              const size_t num_parts);
+
+/* Description: Appends the null terminated character arrays following `s`
+**     to the strlib string `s` in order, as strlib_concat does. The list
+**     of arrays must end with NULL.
+** Parameters:
+**     s   - A pointer to where the strlib string is to be held.
+**     ... - The null terminated character arrays, followed by NULL.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The arrays are placed after the contents of `s`. They must not
+**         refer to the contents of `s` itself.
+*/
+strlib_result_t strlib_concat_cstrs(strlib_str_t *s, ...)
+    __attribute__((sentinel));
+
+/* Description: Appends the characters of the `num_parts` views of `parts`
+**     to the strlib string `s`, with the characters of view `separator`
+**     between every two of them, as strlib_concat does.
+** Parameters:
+**     s         - A pointer to where the strlib string is to be held.
+**     separator - The view of the characters placed between parts.
+**     parts     - The views of the characters to be joined.
+**     num_parts - The number of views in `parts`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The joined parts are placed after the contents of `s`. Neither
+**         they nor `separator` may refer to the contents of `s` itself.
+*/
+strlib_result_t strlib_join(strlib_str_t *s, const strlib_view_t separator,
+                            const strlib_view_t *parts,
+                            const size_t num_parts);
+
 /* Description: Destructs a strlib string `s`.
 ** Parameters:
 **     s - A pointer to the memory address where the strlib string is to be
@@ -355,6 +1431,356 @@ strlib_result_t strlib_set(strlib_str_t *s, const char *buf, const size_t size);
 */
 strlib_result_t strlib_free(strlib_str_t *s);
 
+/* Description: Initializes a streaming search `stream` for the characters of
+**     view `pattern`. Input is fed in chunks of any size, and matches which
+**     span chunk boundaries are still found, while only the last
+**     `pattern.length - 1` characters fed are kept.
+** Parameters:
+**     stream   - A pointer to the memory address where the stream is to be
+**                    held.
+**     pattern  - The characters to be found. They are copied.
+**     callback - The function called with every match, in ascending order.
+**                    Like strlib_find_substr, overlapping matches are all
+**                    reported.
+**     ctx      - The context passed back to `callback`.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) A stream at the the address stored in the pointer `stream`, at
+**         offset 0.
+*/
+strlib_result_t strlib_stream_init(strlib_stream_t **stream,
+                                   const strlib_view_t pattern,
+                                   strlib_match_callback_t callback,
+                                   void *ctx);
+
+/* Description: Feeds the next `length` characters of the input to `stream`.
+** Parameters:
+**     stream - A pointer to where the stream is to be held.
+**     chunk  - The characters which follow those fed before.
+**     length - The number of characters in `chunk`.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The callback of `stream` is called with every match which ends
+**         within `chunk`.
+*/
+strlib_result_t strlib_stream_feed(strlib_stream_t *stream, const char *chunk,
+                                   const size_t length);
+
+/* Description: Starts the search of `stream` over on new input.
+** Parameters:
+**     stream - A pointer to where the stream is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) Characters fed before are forgotten and offsets start at 0 again.
+*/
+strlib_result_t strlib_stream_reset(strlib_stream_t *stream);
+
+/* Description: Destructs the stream `stream`.
+** Parameters:
+**     stream - A pointer to where the stream is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) `stream` is freed and must no longer be used.
+*/
+strlib_result_t strlib_stream_free(strlib_stream_t *stream);
+
+/* Description: Compiles the `num_patterns` views of array `patterns` into a
+**     matcher `matcher` which finds them all in a single pass over a text.
+**     Empty patterns never match.
+** Parameters:
+**     matcher      - A pointer to the memory address where the matcher is to
+**                        be held.
+**     patterns     - The characters to be found. They are not referenced
+**                        once the matcher is compiled.
+**     num_patterns - The number of patterns.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+**     STRLIB_E_BAD_SIZE  - When the patterns are too many or too long.
+** Side Effects:
+**     1) A matcher at the the address stored in the pointer `matcher`.
+*/
+strlib_result_t strlib_matcher_init(strlib_matcher_t **matcher,
+                                    const strlib_view_t *patterns,
+                                    const size_t num_patterns);
+
+/* Description: Finds every pattern of `matcher` in strlib string `s` and
+**     stores the matches into array `matches`, ordered by the index they
+**     end at and then from the longest pattern to the shortest. Overlapping
+**     matches and matches of the same characters by several patterns are
+**     all reported.
+** Parameters:
+**     matcher      - A pointer to where the matcher is to be held.
+**     s            - A pointer to where the strlib string is to be held.
+**     matches      - The matches found.
+**     num_matches  - The number of matches found.
+**     matches_size - The maximum number of matches that can be stored.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+**     STRLIB_E_BAD_SIZE  - When the matches buffer would be overrun.
+** Side Effects:
+**     1) The strlib_match_t array `matches` is updated with the matches.
+**     2) The size_t value pointed to `num_matches` is updated with the
+**         number of matches that were found.
+*/
+strlib_result_t strlib_matcher_find(const strlib_matcher_t *matcher,
+                                    strlib_str_t *s, strlib_match_t *matches,
+                                    size_t *num_matches,
+                                    const size_t matches_size);
+
+/* Description: Finds every pattern of `matcher` in the characters of view
+**     `text`. Behaves like strlib_matcher_find.
+** Parameters:
+**     matcher      - A pointer to where the matcher is to be held.
+**     text         - The view of the chars searched.
+**     matches      - The matches found.
+**     num_matches  - The number of matches found.
+**     matches_size - The maximum number of matches that can be stored.
+** Results:
+**     STRLIB_E_SUCCESS  - When the function exits successfully.
+**     STRLIB_E_BAD_SIZE - When the matches buffer would be overrun.
+** Side Effects:
+**     1) The strlib_match_t array `matches` is updated with the matches.
+**     2) The size_t value pointed to `num_matches` is updated with the
+**         number of matches that were found.
+*/
+strlib_result_t strlib_matcher_find_view(const strlib_matcher_t *matcher,
+                                         const strlib_view_t text,
+                                         strlib_match_t *matches,
+                                         size_t *num_matches,
+                                         const size_t matches_size);
+
+/* Description: Destructs the matcher `matcher`.
+** Parameters:
+**     matcher - A pointer to where the matcher is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) `matcher` is freed and must no longer be used.
+*/
+strlib_result_t strlib_matcher_free(strlib_matcher_t *matcher);
+
+/* Description: Stores in `hash` a 64-bit hash of the contents of the strlib
+**     string `s`. The hash is computed once and cached in the string until
+**     its contents change. It is fast but not cryptographic, and must not be
+**     relied upon against inputs chosen to collide.
+** Parameters:
+**     s    - The strlib string to be hashed.
+**     hash - A pointer to where the hash is to be stored.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) Equal contents hash equally, whether held flat, as a rope, mapped
+**         or as a view passed to strlib_hash_view.
+*/
+strlib_result_t strlib_hash(const strlib_str_t *s, uint64_t *hash);
+
+/* Description: Stores in `hash` the hash of the characters of the view
+**     `view`, which is the hash strlib_hash gives for the same contents.
+** Parameters:
+**     view - The characters to be hashed.
+**     hash - A pointer to where the hash is to be stored.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) The hash of `view` is placed into `hash`.
+*/
+strlib_result_t strlib_hash_view(const strlib_view_t view, uint64_t *hash);
+
+/* Description: Initializes an empty interning table `table`, which keeps a
+**     single read-only strlib string for every distinct contents interned
+**     in it, so that equal contents are compared by comparing pointers.
+**     Tables may be used from several threads at once.
+** Parameters:
+**     table - A pointer to where the table is to be held.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) A table is allocated to `table`, to be released with
+**         strlib_intern_free.
+*/
+strlib_result_t strlib_intern_init(strlib_intern_t **table);
+
+/* Description: Stores in `interned` the strlib string of the table `table`
+**     holding the characters of `view`, adding one if there is none yet.
+**     Interned strings are owned by the table and stay valid until it is
+**     freed. They may be read by the functions taking a const strlib
+**     string, but must never be modified or freed.
+** Parameters:
+**     table    - The table to intern the characters in.
+**     view     - The characters to intern.
+**     interned - A pointer to where the interned string is to be stored.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The characters of `view` are copied to the table if new to it.
+*/
+strlib_result_t strlib_intern(strlib_intern_t *table, const strlib_view_t view,
+                              const strlib_str_t **interned);
+
+/* Description: Stores in `interned` the strlib string of the table `table`
+**     holding the contents of the strlib string `s`, as strlib_intern does.
+** Parameters:
+**     table    - The table to intern the contents in.
+**     s        - The strlib string whose contents are interned.
+**     interned - A pointer to where the interned string is to be stored.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+** Side Effects:
+**     1) The contents of `s` are copied to the table if new to it.
+*/
+strlib_result_t strlib_intern_str(strlib_intern_t *table,
+                                  const strlib_str_t *s,
+                                  const strlib_str_t **interned);
+
+/* Description: Destructs the table `table` with all of its interned strings.
+** Parameters:
+**     table - The table to release.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) `table` and the strings interned in it are freed and must no
+**         longer be used.
+*/
+strlib_result_t strlib_intern_free(strlib_intern_t *table);
+
+/* Description: Initializes a bump arena `arena` which hands out memory from
+**     blocks of `block_size` bytes. Memory is only reclaimed in bulk by
+**     strlib_arena_reset and strlib_arena_free.
+** Parameters:
+**     arena      - A pointer to the memory address where the arena is to be
+**                      held.
+**     block_size - The size of the blocks requested from the system.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+**     STRLIB_E_BAD_SIZE  - When `block_size` is zero.
+** Side Effects:
+**     1) An arena at the the address stored in the pointer `arena`.
+*/
+strlib_result_t strlib_arena_init(strlib_arena_t **arena,
+                                  const size_t block_size);
+
+/* Description: Stores the allocator interface of `arena` in `allocator`, to
+**     be passed to strlib_init_with_allocator.
+** Parameters:
+**     arena     - A pointer to where the arena is to be held.
+**     allocator - The location where the allocator pointer is stored.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) `allocator` points at an allocator that lives as long as `arena`.
+*/
+strlib_result_t strlib_arena_get_allocator(
+    strlib_arena_t *arena, const strlib_allocator_t **allocator);
+
+/* Description: Releases everything allocated from `arena` at once, keeping
+**     its blocks around for reuse.
+** Parameters:
+**     arena - A pointer to where the arena is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) Every strlib string allocated from `arena` becomes invalid and
+**         must not be used or passed to strlib_free.
+*/
+strlib_result_t strlib_arena_reset(strlib_arena_t *arena);
+
+/* Description: Destructs the arena `arena` and all memory allocated from it.
+** Parameters:
+**     arena - A pointer to where the arena is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) Every strlib string allocated from `arena` becomes invalid.
+*/
+strlib_result_t strlib_arena_free(strlib_arena_t *arena);
+
+/* Description: Initializes a pool `pool` of fixed-size objects of
+**     `object_size` bytes, requested from the system `objects_per_chunk` at a
+**     time. Requests larger than `object_size` fail with no memory, so a pool
+**     suits strlib strings whose contents have a known upper bound.
+** Parameters:
+**     pool              - A pointer to the memory address where the pool is
+**                             to be held.
+**     object_size       - The size of every object handed out.
+**     objects_per_chunk - The number of objects allocated together.
+** Results:
+**     STRLIB_E_SUCCESS   - When the function exits successfully.
+**     STRLIB_E_NO_MEMORY - When the function fails to allocate memory.
+**     STRLIB_E_BAD_SIZE  - When `object_size` or `objects_per_chunk` is zero.
+** Side Effects:
+**     1) A pool at the the address stored in the pointer `pool`.
+*/
+strlib_result_t strlib_pool_init(strlib_pool_t **pool, const size_t object_size,
+                                 const size_t objects_per_chunk);
+
+/* Description: Stores the allocator interface of `pool` in `allocator`, to be
+**     passed to strlib_init_with_allocator.
+** Parameters:
+**     pool      - A pointer to where the pool is to be held.
+**     allocator - The location where the allocator pointer is stored.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) `allocator` points at an allocator that lives as long as `pool`.
+*/
+strlib_result_t strlib_pool_get_allocator(strlib_pool_t *pool,
+                                          const strlib_allocator_t **allocator);
+
+/* Description: Returns every object of `pool` to its free list at once.
+** Parameters:
+**     pool - A pointer to where the pool is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) Every strlib string allocated from `pool` becomes invalid and must
+**         not be used or passed to strlib_free.
+*/
+strlib_result_t strlib_pool_reset(strlib_pool_t *pool);
+
+/* Description: Destructs the pool `pool` and all memory allocated from it.
+** Parameters:
+**     pool - A pointer to where the pool is to be held.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) Every strlib string allocated from `pool` becomes invalid.
+*/
+strlib_result_t strlib_pool_free(strlib_pool_t *pool);
+
+/* Description: Stores a snapshot of the instrumentation counters, which are
+**     shared by all strlib strings, in `stats`. Counters are only gathered
+**     when the library is built with STRLIB_INSTRUMENT defined, so that
+**     other builds pay nothing for them.
+** Parameters:
+**     stats - The location where the snapshot is stored.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) `stats` holds the counters accumulated since the last reset, with
+**         one entry in `operations` for every public function.
+*/
+strlib_result_t strlib_get_stats(strlib_stats_t *stats);
+
+/* Description: Sets every instrumentation counter back to zero.
+** Results:
+**     STRLIB_E_SUCCESS - When the function exits successfully.
+** Side Effects:
+**     1) Snapshots taken afterwards only count what happens after the reset.
+*/
+strlib_result_t strlib_reset_stats(void);
+
 #endif  // #ifndef STRLIB_H
 
 /* TODO